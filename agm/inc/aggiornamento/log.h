@@ -49,6 +49,10 @@ namespace agm {
     namespace log {
         void init(const char *filename, bool prefix = true) noexcept;
         void exit() noexcept;
+
+        // log to somewhere other than std::cout.
+        // like std::cerr when std::cout is busy with binary data.
+        void setConsole(std::ostream *console) noexcept;
         std::ostream *getStream() noexcept;
         std::string getPrefix(
             const std::string& file,
@@ -6,6 +6,13 @@ Copyright (C) 2012-2020 tim cotter. All rights reserved.
 
 /**
 simple window interface.
+
+the window is an x11 window with a glx context.
+or it's headless.
+an egl pbuffer with no display.
+works with mesa llvmpipe on machines without a gpu.
+there are no events when headless.
+the draw function is called every time run is called.
 **/
 
 class SimpleWindow {
@@ -30,6 +37,10 @@ public:
     // otherwise it's an XK_ symbol.
     virtual void simpleWindowKeyPressed(int symbol) noexcept;
 
+    // render offscreen instead of opening a window.
+    // call before simpleWindowInit.
+    void simpleWindowSetHeadless(bool headless) noexcept;
+
     // derived classes may (but probably don't need to) override these functions.
     virtual void simpleWindowInit(const char *title, int width, int height) noexcept;
     virtual void simpleWindowExit() noexcept;
@@ -24,6 +24,7 @@ namespace {
     class LogStreams {
     public:
         bool prefix_;
+        std::ostream *console_ = &std::cout;
         std::ofstream file_;
         std::stringstream str_;
     };
@@ -91,6 +92,15 @@ void agm::log::exit() noexcept {
     ls->file_.close();
 }
 
+void agm::log::setConsole(
+    std::ostream *console
+) noexcept {
+    auto m = getLogMutex();
+    std::unique_lock<std::mutex> lock(*m);
+    auto ls = getLogStreams();
+    ls->console_ = console;
+}
+
 std::ostream *agm::log::getStream() noexcept {
     auto ls = getLogStreams();
     return &ls->str_;
@@ -158,7 +168,7 @@ std::ostream & operator<<(
 #if defined(AGM_WINDOWS)
     OutputDebugStringA(ls->str_.str().c_str());
 #endif
-    std::cout << ls->str_.str();
+    *ls->console_ << ls->str_.str();
     // clear the string.
     ls->str_.str(std::string());
     auto m = getLogMutex();
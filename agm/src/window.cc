@@ -10,6 +10,8 @@ simple window implementation.
 #include <aggiornamento/log.h>
 #include <aggiornamento/window.h>
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GL/glx.h>
 #include <X11/Xlib.h>
 
@@ -23,7 +25,112 @@ namespace {
         Atom delete_message_ = 0;
         int width_ = 0;
         int height_ = 0;
+        bool headless_ = false;
+        int headless_width_ = 0;
+        int headless_height_ = 0;
+        EGLDisplay egl_display_ = EGL_NO_DISPLAY;
+        EGLSurface egl_surface_ = EGL_NO_SURFACE;
+        EGLContext egl_context_ = EGL_NO_CONTEXT;
     };
+
+    /*
+    prefer mesa's surfaceless platform.
+    it doesn't need a display server.
+    fall back to whatever egl thinks is the default.
+    */
+    EGLDisplay getHeadlessDisplay() noexcept {
+        EGLDisplay display = EGL_NO_DISPLAY;
+#if defined(EGL_PLATFORM_SURFACELESS_MESA)
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+            eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+#endif
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        return display;
+    }
+
+    bool initHeadless(
+        SimpleWindowData *swd,
+        int width,
+        int height
+    ) noexcept {
+        swd->egl_display_ = getHeadlessDisplay();
+        EGLint major = 0;
+        EGLint minor = 0;
+        if (swd->egl_display_ == EGL_NO_DISPLAY
+        ||  eglInitialize(swd->egl_display_, &major, &minor) == EGL_FALSE) {
+            LOG("Failed to initialize EGL.");
+            return false;
+        }
+        LOG("EGL version=" << major << "." << minor);
+        LOG("EGL vendor=" << eglQueryString(swd->egl_display_, EGL_VENDOR));
+
+        // same as the glx visual.
+        EGLint config_attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+        };
+        EGLConfig config = nullptr;
+        EGLint num_configs = 0;
+        eglChooseConfig(swd->egl_display_, config_attributes, &config, 1, &num_configs);
+        if (num_configs < 1) {
+            LOG("Failed to choose EGL config.");
+            return false;
+        }
+
+        EGLint surface_attributes[] = {
+            EGL_WIDTH, width,
+            EGL_HEIGHT, height,
+            EGL_NONE
+        };
+        swd->egl_surface_ = eglCreatePbufferSurface(swd->egl_display_, config, surface_attributes);
+        if (swd->egl_surface_ == EGL_NO_SURFACE) {
+            LOG("Failed to create EGL pbuffer.");
+            return false;
+        }
+
+        // same kind of context as glx. desktop gl.
+        eglBindAPI(EGL_OPENGL_API);
+        swd->egl_context_ = eglCreateContext(swd->egl_display_, config, EGL_NO_CONTEXT, nullptr);
+        if (swd->egl_context_ == EGL_NO_CONTEXT) {
+            LOG("Failed to create EGL context.");
+            return false;
+        }
+        eglMakeCurrent(swd->egl_display_, swd->egl_surface_, swd->egl_surface_, swd->egl_context_);
+        LOG("GL renderer=" << (const char *) glGetString(GL_RENDERER));
+
+        swd->headless_width_ = width;
+        swd->headless_height_ = height;
+        return true;
+    }
+
+    void exitHeadless(
+        SimpleWindowData *swd
+    ) noexcept {
+        if (swd->egl_display_ == EGL_NO_DISPLAY) {
+            return;
+        }
+        eglMakeCurrent(swd->egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (swd->egl_context_ != EGL_NO_CONTEXT) {
+            eglDestroyContext(swd->egl_display_, swd->egl_context_);
+            swd->egl_context_ = EGL_NO_CONTEXT;
+        }
+        if (swd->egl_surface_ != EGL_NO_SURFACE) {
+            eglDestroySurface(swd->egl_display_, swd->egl_surface_);
+            swd->egl_surface_ = EGL_NO_SURFACE;
+        }
+        eglTerminate(swd->egl_display_);
+        swd->egl_display_ = EGL_NO_DISPLAY;
+    }
 }
 
 SimpleWindow::SimpleWindow() noexcept {
@@ -34,6 +141,17 @@ SimpleWindow::~SimpleWindow() noexcept {
     delete swd;
 }
 
+void SimpleWindow::simpleWindowSetHeadless(
+    bool headless
+) noexcept {
+    auto swd = (SimpleWindowData *) opaque_;
+    if (swd == nullptr) {
+        swd = new(std::nothrow) SimpleWindowData;
+        opaque_ = swd;
+    }
+    swd->headless_ = headless;
+}
+
 void SimpleWindow::simpleWindowInit(
     const char *title,
     int width,
@@ -45,6 +163,19 @@ void SimpleWindow::simpleWindowInit(
         opaque_ = swd;
     }
 
+    // assume we get an expose event.
+    swd->width_ = -1;
+    swd->height_ = -1;
+
+    if (swd->headless_) {
+        auto good = initHeadless(swd, width, height);
+        if (good == false) {
+            exitHeadless(swd);
+            simpleWindowStop();
+        }
+        return;
+    }
+
     swd->display_ = XOpenDisplay(nullptr);
     auto root_window = DefaultRootWindow(swd->display_);
     swd->window_ = XCreateSimpleWindow(
@@ -73,15 +204,16 @@ void SimpleWindow::simpleWindowInit(
     XSelectInput(swd->display_, swd->window_, ExposureMask | KeyPressMask);
     swd->delete_message_ = XInternAtom(swd->display_, "WM_DELETE_WINDOW", False);
     XSetWMProtocols(swd->display_, swd->window_, &swd->delete_message_, 1);
-
-    // assume we get an expose event.
-    swd->width_ = -1;
-    swd->height_ = -1;
 }
 
 void SimpleWindow::simpleWindowExit() noexcept {
     auto swd = (SimpleWindowData *) opaque_;
 
+    if (swd->headless_) {
+        exitHeadless(swd);
+        return;
+    }
+
     XUnmapWindow(swd->display_, swd->window_);
     glXMakeCurrent(swd->display_, None, 0);
     glXDestroyContext(swd->display_, swd->context_);
@@ -93,6 +225,21 @@ void SimpleWindow::simpleWindowExit() noexcept {
 void SimpleWindow::simple_window_run() noexcept {
     auto swd = (SimpleWindowData *) opaque_;
 
+    // no events. the pbuffer never changes size.
+    if (swd->headless_) {
+        if (swd->egl_context_ == EGL_NO_CONTEXT) {
+            return;
+        }
+        if (swd->width_ != swd->headless_width_ || swd->height_ != swd->headless_height_) {
+            swd->width_ = swd->headless_width_;
+            swd->height_ = swd->headless_height_;
+            simpleWindowSize(swd->width_, swd->height_);
+        }
+        simpleWindowDraw();
+        eglSwapBuffers(swd->egl_display_, swd->egl_surface_);
+        return;
+    }
+
     auto available = XPending(swd->display_);
     if (available) {
         XEvent event;
@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+capture rendered frames to numbered png files.
+or to a yuv4mpeg2 video stream.
+
+reading pixels and compressing pngs on the render thread
+is way too slow to keep up with 60 fps.
+so...
+
+the frame buffer is read into a ring of pixel pack buffers.
+the read is asynchronous.
+the pixels are mapped a couple frames later.
+when the gpu is long done with them.
+the mapped pixels are copied to a frame.
+the frame is queued for a pool of writer threads.
+gl frame buffers are upside down.
+the writers write the rows bottom to top.
+
+the queue is bounded.
+the render thread waits if the writers fall too far behind.
+
+a stream needs the frames in order.
+so there is only one writer.
+the size of a stream is fixed by the first frame.
+
+must be called from the thread that owns the gl context.
+**/
+
+#include <string>
+#include <vector>
+
+
+namespace agm {
+    class Container;
+    class Thread;
+}
+class CaptureQueue;
+
+class FrameCapture {
+public:
+    // files are named prefixNNNNN.png
+    // stop capturing after max_frames.
+    FrameCapture(const char *prefix, int max_frames) noexcept;
+    FrameCapture(const FrameCapture &) = delete;
+    ~FrameCapture() noexcept;
+
+    // name ending in .y4m or "-" for stdout writes a video stream.
+    // anything else is the png prefix.
+    // call before the first capture.
+    void setOutput(const char *name) noexcept;
+
+    // read the current frame buffer.
+    // queue older frames for writing.
+    void capture(int width, int height) noexcept;
+
+    // write all pending frames.
+    // release gl resources and stop the writers.
+    // call before the gl context is destroyed.
+    void exit() noexcept;
+
+private:
+    std::string prefix_;
+    bool stream_ = false;
+    int max_frames_;
+    int width_ = 0;
+    int height_ = 0;
+    int stride_ = 0;
+    int num_reads_ = 0;
+    int num_queued_ = 0;
+    unsigned int pixel_buffers_[3] = {0};
+    CaptureQueue *queue_ = nullptr;
+    std::vector<agm::Thread *> threads_;
+    std::vector<agm::Container *> containers_;
+
+    void init(int width, int height) noexcept;
+    void queueOldest() noexcept;
+};
@@ -11,6 +11,8 @@ wrapper for libpng.
 
 #include <png.h>
 
+#include <fstream>
+
 
 class Png {
 public:
@@ -32,3 +34,57 @@ public:
 
     bool write(const char *filename) noexcept;
 };
+
+/**
+read a png one row at a time.
+for images too big to hold in memory.
+the transforms are the same as Png::read.
+interlaced images are not supported.
+**/
+class PngReader {
+public:
+    PngReader() noexcept;
+    PngReader(const PngReader &) = delete;
+    ~PngReader() noexcept;
+
+    int wd_;
+    int ht_;
+    int stride_;
+
+    bool open(const char *filename) noexcept;
+
+    // rows are returned top to bottom.
+    // row must hold stride_ bytes.
+    bool readRow(png_byte *row) noexcept;
+
+    void close() noexcept;
+
+private:
+    std::fstream file_;
+    png_structp png_;
+    png_infop info_;
+};
+
+/**
+write an rgb png one row at a time.
+for images too big to hold in memory.
+**/
+class PngWriter {
+public:
+    PngWriter() noexcept;
+    PngWriter(const PngWriter &) = delete;
+    ~PngWriter() noexcept;
+
+    bool open(const char *filename, int width, int height) noexcept;
+
+    // rows must be written top to bottom.
+    bool writeRow(const png_byte *row) noexcept;
+
+    // finishes the file.
+    bool close() noexcept;
+
+private:
+    std::fstream file_;
+    png_structp png_;
+    png_infop info_;
+};
@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+per-frame timing and draw statistics.
+
+the renderer marks the stages of its frame.
+and counts its draw calls.
+the stats accumulate cpu time per stage, gpu time per frame,
+draw calls, triangles, and a histogram of frame times.
+a summary is logged every few seconds.
+
+gpu time uses timer queries when the driver has them.
+the queries are read a few frames later.
+so they never stall the pipeline.
+
+the overlay draws the recent frame times as bars
+in the bottom left corner.
+green bars made the 60 fps budget. red bars did not.
+the white line is the budget.
+it uses scissored clears. no shaders. no fonts.
+
+does nothing unless enabled.
+must be called from the thread that owns the gl context.
+**/
+
+#include <chrono>
+#include <vector>
+
+
+class FrameStats {
+public:
+    FrameStats() noexcept;
+    FrameStats(const FrameStats &) = delete;
+    ~FrameStats() noexcept;
+
+    void enable(bool overlay) noexcept;
+
+    // call at the start of draw.
+    void beginFrame() noexcept;
+
+    // ends the previous stage. starts the named stage.
+    // name must be a string literal.
+    void stage(const char *name) noexcept;
+
+    void countDraw(int triangles) noexcept;
+
+    // call at the end of draw.
+    // draws the overlay.
+    void endFrame(int width, int height) noexcept;
+
+    // logs the last summary. releases the queries.
+    // call before the gl context is destroyed.
+    void exit() noexcept;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    class Stage {
+    public:
+        const char *name_ = nullptr;
+        double ms_ = 0.0;
+        double frame_ms_ = 0.0;
+    };
+
+    bool enabled_ = false;
+    bool overlay_ = false;
+    bool gpu_timer_ = false;
+    bool in_frame_ = false;
+    int num_frames_ = 0;
+    int num_gpu_frames_ = 0;
+    int over_budget_ = 0;
+    int num_queries_ = 0;
+    int num_read_ = 0;
+    unsigned int queries_[4] = {0};
+    Clock::time_point last_frame_;
+    Clock::time_point stage_start_;
+    int cur_stage_ = -1;
+    std::vector<Stage> stages_;
+    double frame_ms_ = 0.0;
+    double min_frame_ms_ = 0.0;
+    double max_frame_ms_ = 0.0;
+    double cpu_ms_ = 0.0;
+    double gpu_ms_ = 0.0;
+    long long draws_ = 0;
+    long long triangles_ = 0;
+    double frame_cpu_ms_ = 0.0;
+    long long frame_draws_ = 0;
+    long long frame_triangles_ = 0;
+    std::vector<int> histogram_;
+    std::vector<float> recent_;
+    int recent_pos_ = 0;
+
+    void initQueries() noexcept;
+    void readQueries(bool wait) noexcept;
+    void endStage(Clock::time_point now) noexcept;
+    void endFrameCounts() noexcept;
+    void drawOverlay(int width, int height) noexcept;
+    void report() noexcept;
+    void reset() noexcept;
+    double percentile(double fraction) noexcept;
+};
@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+stream textures in the background.
+
+decoding a big png on the render thread delays the first frame.
+so...
+
+load creates the textures immediately.
+with a 1x1 gray placeholder.
+the png is decoded by worker threads.
+the workers also build the mip chain on the cpu.
+update uploads a bounded number of bytes per frame.
+smallest mip level first.
+the base level drops as each level completes.
+so the texture sharpens over a few frames.
+
+the png may be split into strips stacked vertically.
+one texture per strip.
+like the cube textures for the two halves of a sphere.
+
+a png that fails to load becomes a 1x1 black texture.
+
+must be called from the thread that owns the gl context.
+**/
+
+#include <vector>
+
+
+namespace agm {
+    class Container;
+    class Thread;
+}
+class TextureQueue;
+
+class TextureStreamer {
+public:
+    TextureStreamer() noexcept;
+    TextureStreamer(const TextureStreamer &) = delete;
+    ~TextureStreamer() noexcept;
+
+    // creates nstrips textures.
+    // repeat sets the wrap mode to repeat instead of clamp.
+    void load(const char *filename, int nstrips, unsigned int *textures, bool repeat) noexcept;
+
+    // call once per frame.
+    // uploads more of the decoded textures.
+    void update() noexcept;
+
+    // stop the workers and drop pending uploads.
+    // the textures belong to the caller.
+    void exit() noexcept;
+
+private:
+    TextureQueue *queue_ = nullptr;
+    std::vector<agm::Thread *> threads_;
+    std::vector<agm::Container *> containers_;
+
+    void init() noexcept;
+};
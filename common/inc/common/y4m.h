@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+write rgb frames to a yuv4mpeg2 video stream.
+
+the format is a text header followed by raw frames.
+each frame is a line of text followed by the y u v planes.
+ffmpeg and friends read it directly.
+no encoding on the render side.
+
+the pixels are converted to bt.601 studio swing yuv 4:2:0.
+the rows are split into planar ints.
+so the conversion is straight multiply-adds over contiguous arrays.
+which the compiler turns into simd.
+**/
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+
+class Y4mWriter {
+public:
+    Y4mWriter() noexcept;
+    Y4mWriter(const Y4mWriter &) = delete;
+    ~Y4mWriter() noexcept;
+
+    // filename "-" writes to stdout.
+    bool open(const char *filename, int width, int height, int fps) noexcept;
+
+    // rgb pixels. rows are stride bytes apart.
+    // gl frame buffers are bottom to top.
+    bool writeFrame(const std::uint8_t *rgb, int stride, bool bottom_up) noexcept;
+
+    void close() noexcept;
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int chroma_width_ = 0;
+    int chroma_height_ = 0;
+    std::ofstream file_;
+    std::ostream *out_ = nullptr;
+    std::vector<std::uint8_t> y_;
+    std::vector<std::uint8_t> u_;
+    std::vector<std::uint8_t> v_;
+    std::vector<int> planar_[2][3];
+
+    void splitRow(const std::uint8_t *src, std::vector<int> *planar) noexcept;
+    void convertLuma(const std::vector<int> *planar, std::uint8_t *dst) noexcept;
+    void convertChroma(std::uint8_t *dst_u, std::uint8_t *dst_v) noexcept;
+};
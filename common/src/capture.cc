@@ -0,0 +1,379 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+capture rendered frames to numbered png files.
+or to a yuv4mpeg2 video stream.
+
+render thread               writer threads
+--------------------        --------------------
+capture(n)
+    read pixels to pbo n%3
+    map pbo (n-2)%3
+    copy to frame
+    push frame
+        waits if full
+                            pop frame
+                                waits if empty
+                            write rows bottom to top
+                                or convert to yuv and append
+                            release frame
+exit()
+    map remaining pbos
+    push frames
+    wait idle
+    stop writers
+**/
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+#include <common/capture.h>
+#include <common/png.h>
+#include <common/y4m.h>
+
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+
+namespace {
+    const int kNumPixelBuffers = 3;
+    const int kMaxWriters = 4;
+    const int kFramesPerWriter = 2;
+    // the renderers step 1/60 second per frame.
+    const int kStreamFps = 60;
+
+    class Frame {
+    public:
+        int width_ = 0;
+        int height_ = 0;
+        int stride_ = 0;
+        std::vector<png_byte> data_;
+        std::string filename_;
+    };
+}
+
+/*
+bounded queue of frames waiting to be written.
+recycles the frames.
+*/
+class CaptureQueue : public agm::Container {
+public:
+    CaptureQueue(int depth) noexcept :
+        agm::Container("CaptureQueue"),
+        depth_(depth) {
+    }
+
+    virtual ~CaptureQueue() noexcept {
+        delete stream_;
+        for (auto frame : free_) {
+            delete frame;
+        }
+        for (auto frame : queue_) {
+            delete frame;
+        }
+    }
+
+    int depth_;
+    Y4mWriter *stream_ = nullptr;
+    bool unblocked_ = false;
+    int busy_ = 0;
+    std::deque<Frame *> queue_;
+    std::vector<Frame *> free_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    /*
+    called by render thread.
+    returns an unused frame.
+    */
+    Frame *getFree() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            return new(std::nothrow) Frame;
+        }
+        auto frame = free_.back();
+        free_.pop_back();
+        return frame;
+    }
+
+    /*
+    called by render thread.
+    waits while the queue is full.
+    */
+    void push(
+        Frame *frame
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (int(queue_.size()) >= depth_ && unblocked_ == false) {
+                cv_.wait(lock);
+            }
+            queue_.push_back(frame);
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by writer threads.
+    waits while the queue is empty.
+    returns nullptr when unblocked.
+    */
+    Frame *pop() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (queue_.empty() && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (queue_.empty()) {
+            return nullptr;
+        }
+        auto frame = queue_.front();
+        queue_.pop_front();
+        ++busy_;
+        lock.unlock();
+        cv_.notify_all();
+        return frame;
+    }
+
+    /*
+    called by writer threads.
+    the frame has been written.
+    */
+    void release(
+        Frame *frame
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            free_.push_back(frame);
+            --busy_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by render thread.
+    wait for all frames to be written.
+    */
+    void waitIdle() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while ((queue_.size() || busy_) && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+        }
+        cv_.notify_all();
+    }
+};
+
+namespace {
+    class CaptureWriter : public agm::Thread {
+    public:
+        CaptureWriter(
+            CaptureQueue *queue
+        ) noexcept :
+            agm::Thread("CaptureWriter"),
+            queue_(queue) {
+        }
+
+        virtual ~CaptureWriter() = default;
+
+        CaptureQueue *queue_;
+
+        virtual void runOnce() noexcept {
+            auto frame = queue_->pop();
+            if (frame == nullptr) {
+                return;
+            }
+
+            if (queue_->stream_) {
+                queue_->stream_->writeFrame(frame->data_.data(), frame->stride_, true);
+                queue_->release(frame);
+                return;
+            }
+
+            LOG("write=" << frame->filename_);
+            PngWriter png;
+            auto good = png.open(frame->filename_.c_str(), frame->width_, frame->height_);
+            auto row = frame->data_.data() + (frame->height_ - 1) * frame->stride_;
+            for (int i = 0; good && i < frame->height_; ++i) {
+                good = png.writeRow(row);
+                row -= frame->stride_;
+            }
+            png.close();
+
+            queue_->release(frame);
+        }
+    };
+}
+
+FrameCapture::FrameCapture(
+    const char *prefix,
+    int max_frames
+) noexcept :
+    prefix_(prefix),
+    max_frames_(max_frames) {
+}
+
+FrameCapture::~FrameCapture() noexcept {
+    exit();
+}
+
+void FrameCapture::setOutput(
+    const char *name
+) noexcept {
+    std::string s(name);
+    auto ext = std::string(".y4m");
+    stream_ = (s == "-");
+    if (s.size() > ext.size() && s.compare(s.size() - ext.size(), ext.size(), ext) == 0) {
+        stream_ = true;
+    }
+    prefix_ = s;
+    LOG("output=" << prefix_ << " stream=" << stream_);
+}
+
+void FrameCapture::init(
+    int width,
+    int height
+) noexcept {
+    width_ = width;
+    height_ = height;
+    // same as Png::init and the default GL_PACK_ALIGNMENT.
+    stride_ = (3 * width_ + 3) / 4 * 4;
+
+    glGenBuffers(kNumPixelBuffers, pixel_buffers_);
+    for (int i = 0; i < kNumPixelBuffers; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, stride_ * height_, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (queue_ == nullptr) {
+        int nwriters = std::thread::hardware_concurrency() / 2;
+        nwriters = std::max(1, std::min(nwriters, kMaxWriters));
+        if (stream_) {
+            nwriters = 1;
+        }
+        queue_ = new(std::nothrow) CaptureQueue(kFramesPerWriter * nwriters);
+        if (stream_) {
+            queue_->stream_ = new(std::nothrow) Y4mWriter;
+            auto good = queue_->stream_->open(prefix_.c_str(), width_, height_, kStreamFps);
+            if (good == false) {
+                max_frames_ = 0;
+            }
+        }
+        containers_.push_back(queue_);
+        for (int i = 0; i < nwriters; ++i) {
+            threads_.push_back(new(std::nothrow) CaptureWriter(queue_));
+        }
+        agm::Thread::startAll(threads_, containers_);
+        LOG("writers=" << nwriters << " depth=" << queue_->depth_);
+    }
+}
+
+void FrameCapture::capture(
+    int width,
+    int height
+) noexcept {
+    if (num_reads_ >= max_frames_) {
+        return;
+    }
+
+    // the size of a stream is fixed.
+    if (stream_ && width_ && (width != width_ || height != height_)) {
+        LOG("Stream size changed. Stopping capture.");
+        max_frames_ = num_reads_;
+        return;
+    }
+
+    // the size changed. flush the frames in flight.
+    if (width != width_ || height != height_) {
+        while (num_queued_ < num_reads_) {
+            queueOldest();
+        }
+        if (pixel_buffers_[0]) {
+            glDeleteBuffers(kNumPixelBuffers, pixel_buffers_);
+        }
+        init(width, height);
+    }
+
+    // start reading this frame.
+    auto idx = num_reads_ % kNumPixelBuffers;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[idx]);
+    glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    ++num_reads_;
+
+    // the ring is full. finish the oldest read.
+    if (num_reads_ - num_queued_ >= kNumPixelBuffers) {
+        queueOldest();
+    }
+}
+
+void FrameCapture::queueOldest() noexcept {
+    auto frame_number = num_queued_;
+    auto idx = num_queued_ % kNumPixelBuffers;
+    ++num_queued_;
+
+    auto frame = queue_->getFree();
+    frame->width_ = width_;
+    frame->height_ = height_;
+    frame->stride_ = stride_;
+    int size = stride_ * height_;
+    frame->data_.resize(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[idx]);
+    auto pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(frame->data_.data(), pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::stringstream ss;
+    ss << prefix_ << std::setfill('0') << std::setw(5) << frame_number
+        << std::setfill(' ') << std::setw(0) << ".png";
+    frame->filename_ = ss.str();
+    queue_->push(frame);
+}
+
+void FrameCapture::exit() noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+
+    while (num_queued_ < num_reads_) {
+        queueOldest();
+    }
+    queue_->waitIdle();
+
+    // deletes the queue.
+    agm::Thread::stopAll(threads_, containers_);
+    threads_.clear();
+    containers_.clear();
+    queue_ = nullptr;
+
+    // a stream cannot be reopened without clobbering it.
+    if (stream_) {
+        max_frames_ = num_reads_;
+    }
+
+    glDeleteBuffers(kNumPixelBuffers, pixel_buffers_);
+    for (int i = 0; i < kNumPixelBuffers; ++i) {
+        pixel_buffers_[i] = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+}
@@ -247,3 +247,236 @@ bool Png::write(
 
     return result;
 }
+
+PngReader::PngReader() noexcept :
+    wd_(0),
+    ht_(0),
+    stride_(0),
+    png_(nullptr),
+    info_(nullptr)
+{
+}
+
+PngReader::~PngReader() noexcept {
+    close();
+}
+
+bool PngReader::open(
+    const char *filename
+) noexcept {
+    bool result = true;
+    png_byte sig[kPngSigSize];
+    int depth = 0;
+    int channels = 0;
+    int color_type = 0;
+
+    close();
+
+    /*if (result)*/ {
+        file_.open(filename, std::fstream::in | std::fstream::binary);
+        if (file_.is_open() == false) {
+            LOG("Failed to open file \"" << filename << "\"");
+            result = false;
+        }
+    } if (result) {
+        file_.read((char *) sig, sizeof(sig));
+        if (file_.good() == false) {
+            LOG("Failed to read file signature.");
+            result = false;
+        }
+    } if (result) {
+        if (png_sig_cmp(sig, 0, kPngSigSize) != 0) {
+            LOG("File signature not PNG.");
+            result = false;
+        }
+    } if (result) {
+        png_ = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (png_ == nullptr) {
+            LOG("Failed to create PNG read struct.");
+            result = false;
+        }
+    } if (result) {
+        info_ = png_create_info_struct(png_);
+        if (info_ == nullptr) {
+            LOG("Failed to create PNG info struct.");
+            result = false;
+        }
+    } if (result) {
+        if (setjmp(png_jmpbuf(png_))) {
+            LOG("Failed reading PNG header.");
+            result = false;
+        }
+    } if (result) {
+        png_set_read_fn(png_, (png_voidp) &file_, readData);
+
+        png_set_sig_bytes(png_, sizeof(sig));
+        png_read_info(png_, info_);
+
+        wd_ = png_get_image_width(png_, info_);
+        ht_ = png_get_image_height(png_, info_);
+        depth = png_get_bit_depth(png_, info_);
+        channels = png_get_channels(png_, info_);
+        color_type = png_get_color_type(png_, info_);
+
+        if (png_get_interlace_type(png_, info_) != PNG_INTERLACE_NONE) {
+            LOG("Interlaced PNG cannot be read by rows.");
+            result = false;
+        }
+    } if (result) {
+        // same as Png::read.
+        switch (color_type) {
+        case PNG_COLOR_TYPE_PALETTE:
+            png_set_palette_to_rgb(png_);
+            channels = 3;
+            break;
+
+        case PNG_COLOR_TYPE_GRAY:
+            if (depth < 8) {
+                png_set_expand_gray_1_2_4_to_8(png_);
+                depth = 8;
+            }
+            break;
+        }
+        if (depth == 16) {
+            png_set_strip_16(png_);
+            depth = 8;
+        }
+
+        png_read_update_info(png_, info_);
+        stride_ = wd_ * depth * channels / 8;
+    }
+
+    LOG("resolution=" << wd_ << "x" << ht_);
+    LOG("channels=" << channels);
+    LOG("bits/channel=" << depth);
+    LOG("stride=" << stride_);
+
+    if (result == false) {
+        close();
+    }
+
+    return result;
+}
+
+bool PngReader::readRow(
+    png_byte *row
+) noexcept {
+    if (png_ == nullptr) {
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png_))) {
+        LOG("Failed reading PNG row.");
+        return false;
+    }
+    png_read_row(png_, row, nullptr);
+    return true;
+}
+
+void PngReader::close() noexcept {
+    if (png_) {
+        png_destroy_read_struct(&png_, &info_, nullptr);
+        png_ = nullptr;
+        info_ = nullptr;
+    }
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+PngWriter::PngWriter() noexcept :
+    png_(nullptr),
+    info_(nullptr)
+{
+}
+
+PngWriter::~PngWriter() noexcept {
+    close();
+}
+
+bool PngWriter::open(
+    const char *filename,
+    int width,
+    int height
+) noexcept {
+    bool result = true;
+
+    close();
+
+    LOG("resolution=" << width << "x" << height);
+
+    /*if (result)*/ {
+        file_.open(filename, std::fstream::out | std::fstream::binary);
+        if (file_.is_open() == false) {
+            LOG("Failed to open file \"" << filename << "\"");
+            result = false;
+        }
+    } if (result) {
+        png_ = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (png_ == nullptr) {
+            LOG("Failed to create PNG write struct.");
+            result = false;
+        }
+    } if (result) {
+        info_ = png_create_info_struct(png_);
+        if (info_ == nullptr) {
+            LOG("Failed to create PNG info struct.");
+            result = false;
+        }
+    } if (result) {
+        if (setjmp(png_jmpbuf(png_))) {
+            LOG("Failed writing PNG header.");
+            result = false;
+        }
+    } if (result) {
+        png_set_write_fn(png_, (png_voidp) &file_, writeData, nullptr);
+
+        png_set_IHDR(png_, info_, width, height, 8,
+            PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+            PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+        png_write_info(png_, info_);
+    }
+
+    if (result == false) {
+        if (png_) {
+            png_destroy_write_struct(&png_, &info_);
+            png_ = nullptr;
+            info_ = nullptr;
+        }
+        file_.close();
+    }
+
+    return result;
+}
+
+bool PngWriter::writeRow(
+    const png_byte *row
+) noexcept {
+    if (png_ == nullptr) {
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png_))) {
+        LOG("Failed writing PNG row.");
+        return false;
+    }
+    png_write_row(png_, row);
+    return true;
+}
+
+bool PngWriter::close() noexcept {
+    bool result = true;
+    if (png_) {
+        if (setjmp(png_jmpbuf(png_))) {
+            LOG("Failed finishing PNG file.");
+            result = false;
+        } else {
+            png_write_end(png_, nullptr);
+        }
+        png_destroy_write_struct(&png_, &info_);
+        png_ = nullptr;
+        info_ = nullptr;
+    }
+    if (file_.is_open()) {
+        file_.close();
+    }
+    return result;
+}
@@ -0,0 +1,364 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+per-frame timing and draw statistics.
+
+frame n                     later
+--------------------        --------------------
+beginFrame()
+    frame time since n-1
+    begin timer query n%4
+stage("a")
+stage("b")
+    cpu time of a
+endFrame()
+    cpu time of b
+    end timer query
+    read finished queries   gpu time of n-3 or so
+    draw overlay
+    every 300 frames
+        log summary
+**/
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/log.h>
+#include <common/stats.h>
+
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+    // GL_TIME_ELAPSED_EXT is not in the gles3 headers.
+    const GLenum kTimeElapsed = 0x88BF;
+    const int kNumQueries = 4;
+    const int kReportFrames = 300;
+    const double kBudgetMs = 1000.0 / 60.0;
+    // 1 ms buckets. the last one catches everything slower.
+    const int kHistogramBuckets = 100;
+    const int kOverlayFrames = 120;
+    const int kOverlayBarWidth = 2;
+    const int kOverlayPixelsPerMs = 4;
+
+    double elapsedMs(
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point stop
+    ) noexcept {
+        return std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+
+    // don't leave std::fixed on the log stream.
+    double rounded(
+        double value
+    ) noexcept {
+        return std::round(value * 1000.0) / 1000.0;
+    }
+}
+
+FrameStats::FrameStats() noexcept {
+}
+
+FrameStats::~FrameStats() noexcept {
+    exit();
+}
+
+void FrameStats::enable(
+    bool overlay
+) noexcept {
+    enabled_ = true;
+    overlay_ = overlay;
+    histogram_.resize(kHistogramBuckets);
+    recent_.resize(kOverlayFrames);
+    reset();
+    LOG("overlay=" << overlay_);
+}
+
+void FrameStats::beginFrame() noexcept {
+    if (enabled_ == false) {
+        return;
+    }
+    if (queries_[0] == 0) {
+        initQueries();
+    }
+
+    auto now = Clock::now();
+    if (in_frame_) {
+        endFrameCounts();
+        auto ms = elapsedMs(last_frame_, now);
+        frame_ms_ += ms;
+        min_frame_ms_ = (num_frames_ == 0) ? ms : std::min(min_frame_ms_, ms);
+        max_frame_ms_ = std::max(max_frame_ms_, ms);
+        if (ms > kBudgetMs + 1.0) {
+            ++over_budget_;
+        }
+        auto bucket = std::min(int(ms), kHistogramBuckets - 1);
+        ++histogram_[bucket];
+        recent_[recent_pos_] = float(ms);
+        recent_pos_ = (recent_pos_ + 1) % kOverlayFrames;
+        ++num_frames_;
+        if (num_frames_ >= kReportFrames) {
+            report();
+            reset();
+        }
+    }
+    in_frame_ = true;
+    last_frame_ = now;
+    stage_start_ = now;
+    cur_stage_ = -1;
+
+    if (gpu_timer_) {
+        // the slot is still in use. wait for it.
+        if (num_queries_ - num_read_ >= kNumQueries) {
+            readQueries(true);
+        }
+        glBeginQuery(kTimeElapsed, queries_[num_queries_ % kNumQueries]);
+    }
+}
+
+void FrameStats::stage(
+    const char *name
+) noexcept {
+    if (enabled_ == false) {
+        return;
+    }
+    auto now = Clock::now();
+    endStage(now);
+
+    // the stages are usually in the same order every frame.
+    int nstages = stages_.size();
+    int idx = cur_stage_ + 1;
+    if (idx >= nstages || stages_[idx].name_ != name) {
+        idx = 0;
+        while (idx < nstages && std::strcmp(stages_[idx].name_, name) != 0) {
+            ++idx;
+        }
+        if (idx == nstages) {
+            Stage st;
+            st.name_ = name;
+            stages_.push_back(st);
+        }
+    }
+    cur_stage_ = idx;
+    stage_start_ = now;
+}
+
+void FrameStats::countDraw(
+    int triangles
+) noexcept {
+    if (enabled_ == false) {
+        return;
+    }
+    ++frame_draws_;
+    frame_triangles_ += triangles;
+}
+
+void FrameStats::endFrame(
+    int width,
+    int height
+) noexcept {
+    if (enabled_ == false) {
+        return;
+    }
+    endStage(Clock::now());
+    cur_stage_ = -1;
+
+    if (gpu_timer_) {
+        glEndQuery(kTimeElapsed);
+        ++num_queries_;
+        readQueries(false);
+    }
+
+    if (overlay_) {
+        drawOverlay(width, height);
+    }
+}
+
+void FrameStats::exit() noexcept {
+    if (enabled_ == false) {
+        return;
+    }
+    if (num_frames_) {
+        report();
+    }
+    reset();
+    frame_cpu_ms_ = 0.0;
+    frame_draws_ = 0;
+    frame_triangles_ = 0;
+    for (auto& st : stages_) {
+        st.frame_ms_ = 0.0;
+    }
+    if (queries_[0]) {
+        glDeleteQueries(kNumQueries, queries_);
+        for (int i = 0; i < kNumQueries; ++i) {
+            queries_[i] = 0;
+        }
+    }
+    gpu_timer_ = false;
+    in_frame_ = false;
+    num_queries_ = 0;
+    num_read_ = 0;
+}
+
+/*
+timer queries are an extension in gles.
+and core in desktop gl 3.3.
+just try one and see if it fails.
+*/
+void FrameStats::initQueries() noexcept {
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    glGenQueries(kNumQueries, queries_);
+    glBeginQuery(kTimeElapsed, queries_[0]);
+    auto error = glGetError();
+    if (error == GL_NO_ERROR) {
+        glEndQuery(kTimeElapsed);
+        GLuint ns = 0;
+        glGetQueryObjectuiv(queries_[0], GL_QUERY_RESULT, &ns);
+        gpu_timer_ = true;
+    }
+    LOG("gpu_timer=" << gpu_timer_);
+}
+
+void FrameStats::readQueries(
+    bool wait
+) noexcept {
+    while (num_read_ < num_queries_) {
+        auto query = queries_[num_read_ % kNumQueries];
+        if (wait == false) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == 0) {
+                break;
+            }
+        }
+        GLuint ns = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &ns);
+        gpu_ms_ += double(ns) / 1000000.0;
+        ++num_gpu_frames_;
+        ++num_read_;
+        wait = false;
+    }
+}
+
+void FrameStats::endStage(
+    Clock::time_point now
+) noexcept {
+    if (cur_stage_ < 0) {
+        return;
+    }
+    auto ms = elapsedMs(stage_start_, now);
+    stages_[cur_stage_].frame_ms_ += ms;
+    frame_cpu_ms_ += ms;
+}
+
+/*
+the counts of the frame in progress are added to the totals
+when the frame is counted.
+so the averages are over the same frames.
+*/
+void FrameStats::endFrameCounts() noexcept {
+    cpu_ms_ += frame_cpu_ms_;
+    draws_ += frame_draws_;
+    triangles_ += frame_triangles_;
+    frame_cpu_ms_ = 0.0;
+    frame_draws_ = 0;
+    frame_triangles_ = 0;
+    for (auto& st : stages_) {
+        st.ms_ += st.frame_ms_;
+        st.frame_ms_ = 0.0;
+    }
+}
+
+void FrameStats::drawOverlay(
+    int width,
+    int height
+) noexcept {
+    int panel_wd = kOverlayFrames * kOverlayBarWidth;
+    int panel_ht = int(2.0 * kBudgetMs * kOverlayPixelsPerMs);
+    panel_wd = std::min(panel_wd, width);
+    panel_ht = std::min(panel_ht, height);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, panel_wd, panel_ht);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // oldest on the left.
+    for (int i = 0; i < kOverlayFrames; ++i) {
+        auto ms = recent_[(recent_pos_ + i) % kOverlayFrames];
+        int ht = std::min(int(ms * kOverlayPixelsPerMs), panel_ht);
+        if (ht <= 0) {
+            continue;
+        }
+        if (ms <= kBudgetMs + 1.0) {
+            glClearColor(0.0f, 0.8f, 0.0f, 1.0f);
+        } else {
+            glClearColor(0.9f, 0.0f, 0.0f, 1.0f);
+        }
+        glScissor(i * kOverlayBarWidth, 0, kOverlayBarWidth, ht);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glScissor(0, int(kBudgetMs * kOverlayPixelsPerMs), panel_wd, 1);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+void FrameStats::report() noexcept {
+    auto n = std::max(num_frames_, 1);
+    LOG("frames=" << num_frames_
+        << " frame_ms avg=" << rounded(frame_ms_ / n)
+        << " min=" << rounded(min_frame_ms_)
+        << " max=" << rounded(max_frame_ms_)
+        << " p50=" << percentile(0.50)
+        << " p99=" << percentile(0.99)
+        << " over_budget=" << over_budget_);
+    LOG("cpu_ms=" << rounded(cpu_ms_ / n)
+        << " gpu_ms=" << (num_gpu_frames_ ? rounded(gpu_ms_ / num_gpu_frames_) : 0.0)
+        << (gpu_timer_ ? "" : " (no timer)")
+        << " draws=" << rounded(double(draws_) / n)
+        << " triangles=" << rounded(double(triangles_) / n));
+    for (auto& st : stages_) {
+        LOG("  " << st.name_ << "_ms=" << rounded(st.ms_ / n));
+    }
+}
+
+void FrameStats::reset() noexcept {
+    num_frames_ = 0;
+    num_gpu_frames_ = 0;
+    over_budget_ = 0;
+    frame_ms_ = 0.0;
+    min_frame_ms_ = 0.0;
+    max_frame_ms_ = 0.0;
+    cpu_ms_ = 0.0;
+    gpu_ms_ = 0.0;
+    draws_ = 0;
+    triangles_ = 0;
+    for (auto& st : stages_) {
+        st.ms_ = 0.0;
+    }
+    std::fill(histogram_.begin(), histogram_.end(), 0);
+}
+
+/*
+the upper edge of the bucket holding the given fraction of frames.
+*/
+double FrameStats::percentile(
+    double fraction
+) noexcept {
+    int target = int(fraction * num_frames_);
+    int sum = 0;
+    for (int i = 0; i < kHistogramBuckets; ++i) {
+        sum += histogram_[i];
+        if (sum > target) {
+            return double(i + 1);
+        }
+    }
+    return double(kHistogramBuckets);
+}
@@ -0,0 +1,416 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+stream textures in the background.
+
+render thread               decoder threads
+--------------------        --------------------
+load()
+    create placeholders
+    push job
+                            pop job
+                                waits if empty
+                            read png
+                            split strips
+                            build mip chain
+                            finish job
+update()
+    take finished jobs
+    upload rows
+        smallest level first
+        until the budget is spent
+    lower the base level
+        as each level completes
+exit()
+    stop decoders
+    drop pending jobs
+**/
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+#include <common/png.h>
+#include <common/texture.h>
+
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+
+
+namespace {
+    const int kNumDecoders = 2;
+    // keeps the upload from stalling a frame.
+    const int kUploadBytesPerFrame = 4 * 1024 * 1024;
+    const GLubyte kPlaceholderPixel[3] = {0x80, 0x80, 0x80};
+    const GLubyte kMissingPixel[3] = {0x00, 0x00, 0x00};
+
+    class Level {
+    public:
+        int wd_ = 0;
+        int ht_ = 0;
+        // tightly packed rgb rows.
+        std::vector<GLubyte> data_;
+    };
+
+    class Job {
+    public:
+        std::string filename_;
+        std::vector<GLuint> textures_;
+        bool good_ = false;
+        // levels_[strip][level]
+        std::vector<std::vector<Level>> levels_;
+        // upload cursor.
+        // levels count down.
+        // strips count up.
+        int level_ = 0;
+        int strip_ = 0;
+        int row_ = 0;
+    };
+}
+
+/*
+jobs waiting to be decoded.
+jobs waiting to be uploaded.
+*/
+class TextureQueue : public agm::Container {
+public:
+    TextureQueue() noexcept :
+        agm::Container("TextureQueue") {
+    }
+
+    virtual ~TextureQueue() noexcept {
+        for (auto job : pending_) {
+            delete job;
+        }
+        for (auto job : decoded_) {
+            delete job;
+        }
+        for (auto job : uploading_) {
+            delete job;
+        }
+    }
+
+    bool unblocked_ = false;
+    std::deque<Job *> pending_;
+    std::vector<Job *> decoded_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // only touched by the render thread.
+    std::deque<Job *> uploading_;
+
+    /*
+    called by render thread.
+    */
+    void push(
+        Job *job
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pending_.push_back(job);
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by decoder threads.
+    waits while there is nothing to decode.
+    returns nullptr when unblocked.
+    */
+    Job *pop() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (pending_.empty() && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (unblocked_ || pending_.empty()) {
+            return nullptr;
+        }
+        auto job = pending_.front();
+        pending_.pop_front();
+        return job;
+    }
+
+    /*
+    called by decoder threads.
+    the job is ready to upload.
+    */
+    void finish(
+        Job *job
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        decoded_.push_back(job);
+    }
+
+    /*
+    called by render thread.
+    moves decoded jobs to the upload list.
+    */
+    void takeDecoded() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto job : decoded_) {
+            uploading_.push_back(job);
+        }
+        decoded_.clear();
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+        }
+        cv_.notify_all();
+    }
+};
+
+namespace {
+    class TextureDecoder : public agm::Thread {
+    public:
+        TextureDecoder(
+            TextureQueue *queue
+        ) noexcept :
+            agm::Thread("TextureDecoder"),
+            queue_(queue) {
+        }
+
+        virtual ~TextureDecoder() = default;
+
+        TextureQueue *queue_;
+
+        virtual void runOnce() noexcept {
+            auto job = queue_->pop();
+            if (job == nullptr) {
+                return;
+            }
+            decode(job);
+            queue_->finish(job);
+        }
+
+        void decode(
+            Job *job
+        ) noexcept {
+            Png png;
+            int nstrips = job->textures_.size();
+            job->good_ = png.read(job->filename_.c_str());
+            if (job->good_ && png.ht_ < nstrips) {
+                LOG("Too few rows for " << nstrips << " strips.");
+                job->good_ = false;
+            }
+            if (job->good_ == false) {
+                return;
+            }
+
+            auto wd = png.wd_;
+            auto ht = png.ht_ / nstrips;
+            job->levels_.resize(nstrips);
+            for (int s = 0; s < nstrips; ++s) {
+                auto& levels = job->levels_[s];
+                levels.resize(1);
+                auto& level0 = levels[0];
+                level0.wd_ = wd;
+                level0.ht_ = ht;
+                level0.data_.resize(3 * wd * ht);
+                auto src = png.data_ + s * ht * png.stride_;
+                auto dst = level0.data_.data();
+                for (int y = 0; y < ht; ++y) {
+                    std::memcpy(dst, src, 3 * wd);
+                    src += png.stride_;
+                    dst += 3 * wd;
+                }
+
+                for (int i = 1; levels[i-1].wd_ > 1 || levels[i-1].ht_ > 1; ++i) {
+                    levels.resize(i + 1);
+                    halve(levels[i-1], levels[i]);
+                }
+            }
+            job->level_ = job->levels_[0].size() - 1;
+            LOG("decoded=" << job->filename_ << " size=" << wd << "x" << ht
+                << " strips=" << nstrips << " levels=" << job->levels_[0].size());
+        }
+
+        /*
+        2x2 box filter.
+        same as glGenerateMipmap.
+        odd sizes repeat the last row and column.
+        */
+        void halve(
+            const Level &src,
+            Level &dst
+        ) noexcept {
+            dst.wd_ = std::max(1, src.wd_ / 2);
+            dst.ht_ = std::max(1, src.ht_ / 2);
+            dst.data_.resize(3 * dst.wd_ * dst.ht_);
+            auto out = dst.data_.data();
+            for (int y = 0; y < dst.ht_; ++y) {
+                auto y0 = std::min(2*y, src.ht_ - 1);
+                auto y1 = std::min(2*y + 1, src.ht_ - 1);
+                auto row0 = src.data_.data() + 3 * src.wd_ * y0;
+                auto row1 = src.data_.data() + 3 * src.wd_ * y1;
+                for (int x = 0; x < dst.wd_; ++x) {
+                    auto x0 = 3 * std::min(2*x, src.wd_ - 1);
+                    auto x1 = 3 * std::min(2*x + 1, src.wd_ - 1);
+                    for (int c = 0; c < 3; ++c) {
+                        int sum = row0[x0+c] + row0[x1+c] + row1[x0+c] + row1[x1+c];
+                        *out++ = GLubyte((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    };
+
+    void setPixel(
+        GLuint texture,
+        const GLubyte *pixel
+    ) noexcept {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, pixel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    /*
+    upload rows until the budget is spent.
+    returns the number of bytes uploaded.
+    */
+    int uploadSome(
+        Job *job,
+        int budget
+    ) noexcept {
+        if (job->good_ == false) {
+            for (auto texture : job->textures_) {
+                setPixel(texture, kMissingPixel);
+            }
+            job->level_ = -1;
+            return 0;
+        }
+
+        int nstrips = job->textures_.size();
+        int nlevels = job->levels_[0].size();
+        int used = 0;
+        while (used < budget && job->level_ >= 0) {
+            auto& level = job->levels_[job->strip_][job->level_];
+            int row_bytes = 3 * level.wd_;
+            glBindTexture(GL_TEXTURE_2D, job->textures_[job->strip_]);
+            if (job->row_ == 0) {
+                glTexImage2D(GL_TEXTURE_2D, job->level_, GL_RGB, level.wd_, level.ht_,
+                    0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            }
+            int nrows = std::max(1, (budget - used) / row_bytes);
+            nrows = std::min(nrows, level.ht_ - job->row_);
+            auto data = level.data_.data() + job->row_ * row_bytes;
+            glTexSubImage2D(GL_TEXTURE_2D, job->level_, 0, job->row_, level.wd_, nrows,
+                GL_RGB, GL_UNSIGNED_BYTE, data);
+            used += nrows * row_bytes;
+            job->row_ += nrows;
+            if (job->row_ < level.ht_) {
+                continue;
+            }
+
+            // the level is complete. sample from it.
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job->level_);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nlevels - 1);
+            job->row_ = 0;
+            ++job->strip_;
+            if (job->strip_ >= nstrips) {
+                job->strip_ = 0;
+                --job->level_;
+            }
+        }
+        return used;
+    }
+}
+
+TextureStreamer::TextureStreamer() noexcept {
+}
+
+TextureStreamer::~TextureStreamer() noexcept {
+    exit();
+}
+
+void TextureStreamer::init() noexcept {
+    queue_ = new(std::nothrow) TextureQueue;
+    containers_.push_back(queue_);
+    for (int i = 0; i < kNumDecoders; ++i) {
+        threads_.push_back(new(std::nothrow) TextureDecoder(queue_));
+    }
+    agm::Thread::startAll(threads_, containers_);
+}
+
+void TextureStreamer::load(
+    const char *filename,
+    int nstrips,
+    unsigned int *textures,
+    bool repeat
+) noexcept {
+    if (queue_ == nullptr) {
+        init();
+    }
+
+    auto job = new(std::nothrow) Job;
+    job->filename_ = filename;
+    job->textures_.resize(nstrips);
+    glGenTextures(nstrips, job->textures_.data());
+
+    auto wrap = repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < nstrips; ++i) {
+        auto texture = job->textures_[i];
+        setPixel(texture, kPlaceholderPixel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        textures[i] = texture;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    LOG("load=" << filename << " strips=" << nstrips);
+    queue_->push(job);
+}
+
+void TextureStreamer::update() noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+    queue_->takeDecoded();
+    auto& uploading = queue_->uploading_;
+    if (uploading.empty()) {
+        return;
+    }
+
+    // the levels are tightly packed.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    int budget = kUploadBytesPerFrame;
+    while (budget > 0 && uploading.size()) {
+        auto job = uploading.front();
+        budget -= uploadSome(job, budget);
+        if (job->level_ >= 0) {
+            break;
+        }
+        LOG("uploaded=" << job->filename_);
+        uploading.pop_front();
+        delete job;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureStreamer::exit() noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+
+    // deletes the queue and the jobs.
+    agm::Thread::stopAll(threads_, containers_);
+    threads_.clear();
+    containers_.clear();
+    queue_ = nullptr;
+}
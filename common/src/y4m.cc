@@ -0,0 +1,189 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+write rgb frames to a yuv4mpeg2 video stream.
+
+bt.601 studio swing in 8 bit fixed point:
+y = ( 66 r + 129 g +  25 b) / 256 +  16
+u = (-38 r -  74 g + 112 b) / 256 + 128
+v = (112 r -  94 g -  18 b) / 256 + 128
+
+chroma is the average of a 2x2 block.
+so the sums are 4x and the shift is 10 instead of 8.
+odd widths and heights repeat the last column and row.
+
+the loop counts are copied to locals.
+byte stores could alias the members.
+which keeps the compiler from vectorizing.
+**/
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/log.h>
+#include <common/y4m.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+Y4mWriter::Y4mWriter() noexcept {
+}
+
+Y4mWriter::~Y4mWriter() noexcept {
+    close();
+}
+
+bool Y4mWriter::open(
+    const char *filename,
+    int width,
+    int height,
+    int fps
+) noexcept {
+    close();
+
+    LOG("resolution=" << width << "x" << height << " fps=" << fps);
+
+    if (std::strcmp(filename, "-") == 0) {
+        out_ = &std::cout;
+    } else {
+        file_.open(filename, std::fstream::out | std::fstream::binary);
+        if (file_.is_open() == false) {
+            LOG("Failed to open file \"" << filename << "\"");
+            return false;
+        }
+        out_ = &file_;
+    }
+
+    width_ = width;
+    height_ = height;
+    chroma_width_ = (width_ + 1) / 2;
+    chroma_height_ = (height_ + 1) / 2;
+    y_.resize(width_ * height_);
+    u_.resize(chroma_width_ * chroma_height_);
+    v_.resize(chroma_width_ * chroma_height_);
+    for (int i = 0; i < 2; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            planar_[i][c].resize(2 * chroma_width_);
+        }
+    }
+
+    *out_ << "YUV4MPEG2 W" << width_ << " H" << height_
+        << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+    return out_->good();
+}
+
+bool Y4mWriter::writeFrame(
+    const std::uint8_t *rgb,
+    int stride,
+    bool bottom_up
+) noexcept {
+    if (out_ == nullptr) {
+        return false;
+    }
+
+    auto y = y_.data();
+    auto u = u_.data();
+    auto v = v_.data();
+    for (int cy = 0; cy < chroma_height_; ++cy) {
+        for (int i = 0; i < 2; ++i) {
+            int row = std::min(2*cy + i, height_ - 1);
+            if (bottom_up) {
+                row = height_ - 1 - row;
+            }
+            splitRow(rgb + row * stride, planar_[i]);
+        }
+        convertLuma(planar_[0], y);
+        y += width_;
+        if (2*cy + 1 < height_) {
+            convertLuma(planar_[1], y);
+            y += width_;
+        }
+        convertChroma(u, v);
+        u += chroma_width_;
+        v += chroma_width_;
+    }
+
+    *out_ << "FRAME\n";
+    out_->write((const char *) y_.data(), y_.size());
+    out_->write((const char *) u_.data(), u_.size());
+    out_->write((const char *) v_.data(), v_.size());
+    out_->flush();
+    if (out_->good() == false) {
+        LOG("Failed writing Y4M frame.");
+        return false;
+    }
+    return true;
+}
+
+void Y4mWriter::close() noexcept {
+    if (out_) {
+        out_->flush();
+        out_ = nullptr;
+    }
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void Y4mWriter::splitRow(
+    const std::uint8_t *src,
+    std::vector<int> *planar
+) noexcept {
+    auto r = planar[0].data();
+    auto g = planar[1].data();
+    auto b = planar[2].data();
+    int wd = width_;
+    for (int x = 0; x < wd; ++x) {
+        r[x] = src[3*x+0];
+        g[x] = src[3*x+1];
+        b[x] = src[3*x+2];
+    }
+    if (width_ & 1) {
+        r[width_] = r[width_-1];
+        g[width_] = g[width_-1];
+        b[width_] = b[width_-1];
+    }
+}
+
+void Y4mWriter::convertLuma(
+    const std::vector<int> *planar,
+    std::uint8_t *dst
+) noexcept {
+    auto r = planar[0].data();
+    auto g = planar[1].data();
+    auto b = planar[2].data();
+    int wd = width_;
+    for (int x = 0; x < wd; ++x) {
+        dst[x] = std::uint8_t(((66*r[x] + 129*g[x] + 25*b[x] + 128) >> 8) + 16);
+    }
+}
+
+void Y4mWriter::convertChroma(
+    std::uint8_t *dst_u,
+    std::uint8_t *dst_v
+) noexcept {
+    // add the rows first.
+    // fewer pointers means fewer alias checks.
+    int wd = 2 * chroma_width_;
+    for (int c = 0; c < 3; ++c) {
+        auto p0 = planar_[0][c].data();
+        auto p1 = planar_[1][c].data();
+        for (int x = 0; x < wd; ++x) {
+            p0[x] += p1[x];
+        }
+    }
+
+    auto rs = planar_[0][0].data();
+    auto gs = planar_[0][1].data();
+    auto bs = planar_[0][2].data();
+    wd = chroma_width_;
+    for (int x = 0; x < wd; ++x) {
+        int r = rs[2*x] + rs[2*x+1];
+        int g = gs[2*x] + gs[2*x+1];
+        int b = bs[2*x] + bs[2*x+1];
+        dst_u[x] = std::uint8_t(((-38*r - 74*g + 112*b + 512) >> 10) + 128);
+        dst_v[x] = std::uint8_t(((112*r - 94*g - 18*b + 512) >> 10) + 128);
+    }
+}
@@ -25,8 +25,10 @@ and render them separately.
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 #include <aggiornamento/opengl.h>
-#include <common/png.h>
+#include <common/capture.h>
 #include <common/sphere.h>
+#include <common/stats.h>
+#include <common/texture.h>
 
 #include <GLES3/gl3.h>
 
@@ -35,8 +37,6 @@ and render them separately.
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <sstream>
-#include <iomanip>
 
 
 namespace {
@@ -101,7 +101,23 @@ namespace {
         int num_indexes_ = 0;
         float angle_ = 0.0f;
         glm::mat4 rotxz_;
-        int frame_count_ = 0;
+        FrameCapture capture_{"output/world", 48*60};
+        bool capture_on_ = false;
+        FrameStats stats_;
+        TextureStreamer streamer_;
+
+        virtual void setCapture(
+            const char *name
+        ) noexcept {
+            capture_.setOutput(name);
+            capture_on_ = true;
+        }
+
+        virtual void setStats(
+            bool overlay
+        ) noexcept {
+            stats_.enable(overlay);
+        }
 
         virtual void init(
             int width,
@@ -206,6 +222,9 @@ namespace {
         }
 
         virtual void exit() noexcept {
+            stats_.exit();
+            capture_.exit();
+            streamer_.exit();
             if (program_) {
                 if (fragment_shader_) {
                     glDetachShader(program_, fragment_shader_);
@@ -247,6 +266,11 @@ namespace {
         }
 
         virtual void draw() noexcept {
+            stats_.beginFrame();
+            stats_.stage("textures");
+            streamer_.update();
+            stats_.stage("draw");
+
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -289,12 +313,14 @@ namespace {
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, tex_.front_);
             glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
 
             model_mat = model_mat * rotxz_;
             glUniformMatrix4fv(model_mat_loc_, 1, GL_FALSE, &model_mat[0][0]);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, tex_.back_);
             glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
 
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, 0);
@@ -305,7 +331,11 @@ namespace {
             glDisableVertexAttribArray(0);
             glUseProgram(0);
 
-            //captureFrame();
+            stats_.stage("capture");
+            if (capture_on_) {
+                captureFrame();
+            }
+            stats_.endFrame(width_, height_);
         }
 
         virtual void resize(
@@ -329,39 +359,15 @@ namespace {
             const char *filename,
             SphereTexture *texture
         ) noexcept {
-            Png png;
-            png.read(filename);
-            auto ht2 = png.ht_ / 2;
-            auto data = png.data_;
-            texture->front_ = loadTexture(png.wd_, ht2, data);
+            // the top and bottom strips.
+            GLuint textures[2];
+            streamer_.load(filename, 2, textures, false);
+            texture->front_ = textures[0];
             LOG("front=" << texture->front_);
-            data += png.stride_ * ht2;
-            texture->back_ = loadTexture(png.wd_, ht2, data);
+            texture->back_ = textures[1];
             LOG("back=" << texture->back_);
         }
 
-        GLuint loadTexture(
-            int width,
-            int height,
-            GLubyte *data
-        ) noexcept {
-            GLuint texture = 0;
-            glGenTextures(1, &texture);
-
-            glBindTexture(GL_TEXTURE_2D, texture);
-            {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glGenerateMipmap(GL_TEXTURE_2D);
-            }
-            glBindTexture(GL_TEXTURE_2D, 0);
-
-            return texture;
-        }
-
         int calcSegments(
             int width,
             int height
@@ -373,32 +379,7 @@ namespace {
         }
 
         void captureFrame() noexcept {
-            if (frame_count_ >= 48*60) {
-                return;
-            }
-
-            Png png_flipped;
-            png_flipped.init(width_, height_);
-            glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, png_flipped.data_);
-            //png_flipped.write("flipped.png");
-
-            Png png;
-            png.init(width_, height_);
-            auto src = png_flipped.data_ + (height_ - 1)*png_flipped.stride_;
-            auto dst = png.data_;
-            for (int i = 0; i < height_; ++i) {
-                std::memcpy(dst, src, png.stride_);
-                src -= png_flipped.stride_;
-                dst += png.stride_;
-            }
-
-            std::stringstream ss;
-            ss << "output/world" << std::setfill('0') << std::setw(5) << frame_count_
-                << std::setfill(' ') << std::setw(0) << ".png";
-            LOG("ss=" << ss.str().c_str());
-            png.write(ss.str().c_str());
-
-            ++frame_count_;
+            capture_.capture(width_, height_);
         }
     };
 }
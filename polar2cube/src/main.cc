@@ -43,10 +43,16 @@ the faces in the original texture look like this:
 the image is anti-aliased by 4x in each direction.
 which makes it look somewhat blurry.
 gimp filter enhance sharpen somewhere around 50 looks good.
+or use --sharpen 50 to do it here.
 
 *** caution ***
 be sure to sharpen the top strip and bottom strips separately.
 otherwise they'll bleed (anti-bleed?) into each other.
+--sharpen takes care of that.
+
+--tiled converts textures that are too big to fit in memory.
+the polar texture is streamed.
+only a band of rows is kept.
 **/
 
 #include <aggiornamento/aggiornamento.h>
@@ -54,10 +60,24 @@ otherwise they'll bleed (anti-bleed?) into each other.
 #include <aggiornamento/log.h>
 #include <common/png.h>
 
+#include "sharpen.h"
+
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
 
 
 namespace {
+    // width of the unsharp mask blur in output pixels.
+    const double kSharpenSigma = 1.0;
+
+    // smallest tile for tiled mode in output pixels.
+    const int kMinTileSize = 16;
+
     class Vector3 {
     public:
         double x_;
@@ -79,6 +99,19 @@ namespace {
         int br_;
     };
 
+    // tiled mode copies a rectangle of a face.
+    // using rows first_ to last_ of the polar texture.
+    class Tile {
+    public:
+        int face_;
+        int x_;
+        int y_;
+        int wd_;
+        int ht_;
+        int first_;
+        int last_;
+    };
+
     Vector3 g_cube_vertexes[8] = {
         {+1.0, +1.0, +1.0},
         {-1.0, +1.0, +1.0},
@@ -117,10 +150,18 @@ namespace {
 
         const char *input_filename_ = nullptr;
         const char *output_filename_ = nullptr;
+        double sharpen_ = 0.0;
+        int tiled_mb_ = 0;
         Png inpng_;
         Png outpng_;
         double *xweights_ = nullptr;
         double *yweights_ = nullptr;
+        int src_wd_ = 0;
+        int src_ht_ = 0;
+        int out_wd_ = 0;
+        int out_ht_ = 0;
+        png_byte *window_ = nullptr;
+        int window_rows_ = 0;
 
         bool parseOptions(
             int argc,
@@ -133,9 +174,11 @@ namespace {
                 {"help",        '?'},
                 {"input-file",  'i'},
                 {"output-file", 'o'},
+                {"sharpen",     's'},
+                {"tiled",       't'},
                 {nullptr, 0}
             };
-            agm::CmdLineOptions clo(argc, argv, "?i:o:", cmd_line_options);
+            agm::CmdLineOptions clo(argc, argv, "?i:o:s:t:", cmd_line_options);
             while (clo.get()) {
                 switch (clo.option_) {
                 case '?':
@@ -149,6 +192,14 @@ namespace {
                 case 'o':
                     output_filename_ = clo.value_;
                     break;
+
+                case 's':
+                    sharpen_ = std::atof(clo.value_);
+                    break;
+
+                case 't':
+                    tiled_mb_ = std::atoi(clo.value_);
+                    break;
                 }
             }
             if (clo.error_) {
@@ -175,6 +226,8 @@ namespace {
 
             LOG("input  file=\"" << input_filename_ << "\"");
             LOG("output file=\"" << output_filename_ << "\"");
+            LOG("sharpen    =" << sharpen_);
+            LOG("tiled MB   =" << tiled_mb_);
 
             return result;
         }
@@ -184,6 +237,8 @@ namespace {
             LOG("  --help        -?  show this message");
             LOG("  --input-file  -i  input file");
             LOG("  --output-file -o  output file");
+            LOG("  --sharpen     -s  unsharp mask amount (50 is good)");
+            LOG("  --tiled       -t  convert in tiles using this many MB");
         }
 
         void copyAllFaces() noexcept {
@@ -193,8 +248,13 @@ namespace {
             xweights_ = initWeights(wd);
             yweights_ = initWeights(ht);
 
+            src_wd_ = inpng_.wd_;
+            src_ht_ = inpng_.ht_;
             for (int i = 0; i < 6; ++i) {
-                copyFace(i);
+                auto fx = (i % 3) * wd;
+                auto fy = (i / 3) * ht;
+                auto dst = outpng_.data_ + fy*outpng_.stride_ + 3*fx;
+                copyTile(i, 0, 0, wd, ht, dst, outpng_.stride_);
             }
         }
 
@@ -214,67 +274,103 @@ namespace {
             return weights;
         }
 
-        void copyFace(
-            int face
+        /*
+        project an over-sampled pixel of a face onto the sphere.
+        return the pixel in the polar texture.
+        x and y are in over-sampled pixels.
+        */
+        Coords project(
+            int face,
+            int x,
+            int y
         ) noexcept {
-            auto pi = std::acos(-1);
-            auto cf = g_cube_faces[face];
-            auto tl = g_cube_vertexes[cf.tl_];
-            auto tr = g_cube_vertexes[cf.tr_];
-            auto bl = g_cube_vertexes[cf.bl_];
-            auto br = g_cube_vertexes[cf.br_];
+            const auto pi = M_PI;
+            auto& cf = g_cube_faces[face];
+            auto& tl = g_cube_vertexes[cf.tl_];
+            auto& tr = g_cube_vertexes[cf.tr_];
+            auto& bl = g_cube_vertexes[cf.bl_];
+            auto& br = g_cube_vertexes[cf.br_];
+
+            auto tf = yweights_[y];
+            auto bf = 1.0 - tf;
+            Vector3 l;
+            l.x_ = tl.x_*tf + bl.x_*bf;
+            l.y_ = tl.y_*tf + bl.y_*bf;
+            l.z_ = tl.z_*tf + bl.z_*bf;
+            Vector3 r;
+            r.x_ = tr.x_*tf + br.x_*bf;
+            r.y_ = tr.y_*tf + br.y_*bf;
+            r.z_ = tr.z_*tf + br.z_*bf;
+
+            auto lf = xweights_[x];
+            auto rf = 1.0 - lf;
+            Vector3 v;
+            v.x_ = l.x_*lf + r.x_*rf;
+            v.y_ = l.y_*lf + r.y_*rf;
+            v.z_ = l.z_*lf + r.z_*rf;
+            auto r2 = v.x_*v.x_ + v.y_*v.y_ + v.z_*v.z_;
+            auto den = 1.0 / std::sqrt(r2);
+            v.x_ *= den;
+            v.y_ *= den;
+            v.z_ *= den;
+            auto a = atan2(-v.z_, v.x_);  // -pi (left) to +pi (right)
+            auto b = asin(v.y_);         // -pi/2 (bottom) to +pi/2 (top)
+            a = (a/pi + 1.0)/2.0;
+            b = 0.5 - b/pi;
+
+            // +pi rounds to the right edge. which is the left edge.
+            Coords c;
+            c.x_ = (int) std::round(a*src_wd_);
+            c.y_ = (int) std::round(b*src_ht_);
+            if (c.x_ >= src_wd_) {
+                c.x_ -= src_wd_;
+            }
+            c.y_ = std::min(std::max(c.y_, 0), src_ht_ - 1);
+            return c;
+        }
 
-            auto wd = outpng_.wd_ / 3;
-            auto ht = outpng_.ht_ / 2;
-            auto fx = (face % 3) * wd;
-            auto fy = (face / 3) * ht;
-            auto dst_row = outpng_.data_ + fy*outpng_.stride_ + 3*fx;
+        /*
+        rows of the polar texture.
+        either all of it or the rows in the sliding window.
+        */
+        png_byte *sourceRow(
+            int ty
+        ) noexcept {
+            if (window_) {
+                return window_ + (ty % window_rows_) * inpng_.stride_;
+            }
+            return inpng_.data_ + ty*inpng_.stride_;
+        }
 
-            auto aawd = 4 * wd;
-            auto aaht = 4 * ht;
+        /*
+        copy a rectangle of a face.
+        x0 y0 wd ht are in output pixels relative to the face.
+        */
+        void copyTile(
+            int face,
+            int x0,
+            int y0,
+            int wd,
+            int ht,
+            png_byte *dst_row,
+            int dst_stride
+        ) noexcept {
             auto temp_row = new(std::nothrow) int[3*wd];
             std::memset(temp_row, 0, sizeof(int)*3*wd);
 
-            for (int y = 0; y < aaht; ++y) {
+            auto aax0 = 4 * x0;
+            auto aay0 = 4 * y0;
+            auto aawd = 4 * wd;
+            auto aaht = 4 * ht;
+            for (int y = aay0; y < aay0 + aaht; ++y) {
                 int rc = 0;
                 int gc = 0;
                 int bc = 0;
 
                 auto tempr = temp_row;
-                auto tf = yweights_[y];
-                auto bf = 1.0 - tf;
-                Vector3 l;
-                l.x_ = tl.x_*tf + bl.x_*bf;
-                l.y_ = tl.y_*tf + bl.y_*bf;
-                l.z_ = tl.z_*tf + bl.z_*bf;
-                Vector3 r;
-                r.x_ = tr.x_*tf + br.x_*bf;
-                r.y_ = tr.y_*tf + br.y_*bf;
-                r.z_ = tr.z_*tf + br.z_*bf;
-                for (int x = 0; x < aawd; ++x) {
-                    auto lf = xweights_[x];
-                    auto rf = 1.0 - lf;
-                    Vector3 v;
-                    v.x_ = l.x_*lf + r.x_*rf;
-                    v.y_ = l.y_*lf + r.y_*rf;
-                    v.z_ = l.z_*lf + r.z_*rf;
-                    auto r2 = v.x_*v.x_ + v.y_*v.y_ + v.z_*v.z_;
-                    auto den = 1.0 / std::sqrt(r2);
-                    v.x_ *= den;
-                    v.y_ *= den;
-                    v.z_ *= den;
-                    auto a = atan2(-v.z_, v.x_);  // -pi (left) to +pi (right)
-                    auto b = asin(v.y_);         // -pi/2 (bottom) to +pi/2 (top)
-                    /*if (face == 0) {
-                        if (x == 0 || y == 0) {
-                            LOG("x,y=" << x << "," << y << " a,b=" << a << "," << b);
-                        }
-                    }*/
-                    a = (a/pi + 1.0)/2.0;
-                    b = 0.5 - b/pi;
-                    int tx = (int) std::round(a*inpng_.wd_);
-                    int ty = (int) std::round(b*inpng_.ht_);
-                    auto src = inpng_.data_ + ty*inpng_.stride_ + 3*tx;
+                for (int x = aax0; x < aax0 + aawd; ++x) {
+                    auto c = project(face, x, y);
+                    auto src = sourceRow(c.y_) + 3*c.x_;
                     rc += (int)(unsigned int) src[0];
                     gc += (int)(unsigned int) src[1];
                     bc += (int)(unsigned int) src[2];
@@ -303,12 +399,200 @@ namespace {
                         dst += 3;
                         tempr += 3;
                     }
-                    dst_row += outpng_.stride_;
+                    dst_row += dst_stride;
                 }
             }
 
             delete[] temp_row;
         }
+
+        /*
+        tiled conversion for textures too big to fit in memory.
+
+        the output is cut into square tiles.
+        each tile needs a band of rows of the polar texture.
+        the polar texture is read once top to bottom.
+        a sliding window keeps the rows for the tiles in progress.
+        a tile is copied as soon as its last row arrives.
+        finished tiles are spooled to a raw file.
+        which is encoded to png row by row at the end.
+
+        the tile size is the largest that fits the memory budget.
+        */
+        bool convertTiled() noexcept {
+            PngReader reader;
+            auto good = reader.open(input_filename_);
+            if (good == false) {
+                return false;
+            }
+            src_wd_ = reader.wd_;
+            src_ht_ = reader.ht_;
+            inpng_.stride_ = reader.stride_;
+
+            // same as in memory.
+            out_wd_ = (src_wd_ + 3) / 4 * 3;
+            out_ht_ = (src_ht_ + 1) / 2 * 2;
+            auto face_wd = out_wd_ / 3;
+            auto face_ht = out_ht_ / 2;
+            destruct();
+            xweights_ = initWeights(face_wd);
+            yweights_ = initWeights(face_ht);
+
+            std::int64_t budget = std::int64_t(tiled_mb_) * 1024 * 1024;
+            int tile = 1;
+            while (tile < std::max(face_wd, face_ht)) {
+                tile *= 2;
+            }
+            std::vector<Tile> tiles;
+            int span = 0;
+            for (;;) {
+                planTiles(tile, tiles, span);
+                std::int64_t need = std::int64_t(span) * reader.stride_
+                    + std::int64_t(tile) * tile * 3;
+                LOG("tile=" << tile << " window rows=" << span << " bytes=" << need);
+                if (need <= budget || tile <= kMinTileSize) {
+                    if (need > budget) {
+                        LOG("Memory budget too small. Using " << (need >> 20) << " MB.");
+                    }
+                    break;
+                }
+                tile /= 2;
+            }
+
+            window_rows_ = span;
+            window_ = new(std::nothrow) png_byte[std::int64_t(span) * reader.stride_];
+            auto tile_stride = 3 * tile;
+            auto tile_data = new(std::nothrow) png_byte[std::int64_t(tile) * tile_stride];
+
+            std::string spool_filename = output_filename_;
+            spool_filename += ".raw";
+            std::fstream spool(spool_filename.c_str(),
+                std::fstream::in | std::fstream::out | std::fstream::binary | std::fstream::trunc);
+            if (spool.is_open() == false) {
+                LOG("Failed to open file \"" << spool_filename << "\"");
+                good = false;
+            }
+
+            std::int64_t spool_stride = 3 * out_wd_;
+            auto next = tiles.begin();
+            for (int y = 0; good && y < src_ht_; ++y) {
+                good = reader.readRow(sourceRow(y));
+                for (; good && next != tiles.end() && next->last_ == y; ++next) {
+                    auto& t = *next;
+                    copyTile(t.face_, t.x_, t.y_, t.wd_, t.ht_, tile_data, tile_stride);
+
+                    auto fx = (t.face_ % 3) * face_wd + t.x_;
+                    auto fy = (t.face_ / 3) * face_ht + t.y_;
+                    auto src = tile_data;
+                    for (int k = 0; k < t.ht_; ++k, src += tile_stride) {
+                        spool.seekp(std::int64_t(fy + k) * spool_stride + 3*fx);
+                        spool.write((const char *) src, 3 * t.wd_);
+                    }
+                }
+            }
+            reader.close();
+            delete[] tile_data;
+            delete[] window_;
+            window_ = nullptr;
+
+            if (good) {
+                PngWriter writer;
+                good = writer.open(output_filename_, out_wd_, out_ht_);
+                auto row = new(std::nothrow) png_byte[spool_stride];
+                spool.seekg(0);
+                for (int y = 0; good && y < out_ht_; ++y) {
+                    spool.read((char *) row, spool_stride);
+                    good = writer.writeRow(row);
+                }
+                delete[] row;
+                if (writer.close() == false) {
+                    good = false;
+                }
+            }
+            spool.close();
+            std::remove(spool_filename.c_str());
+
+            return good;
+        }
+
+        /*
+        cut the faces into tiles.
+        find the band of polar rows each tile needs.
+        return the tiles sorted by the last row.
+        and the tallest band.
+        */
+        void planTiles(
+            int tile,
+            std::vector<Tile> &tiles,
+            int &span
+        ) noexcept {
+            auto face_wd = out_wd_ / 3;
+            auto face_ht = out_ht_ / 2;
+            tiles.clear();
+            span = 0;
+            for (int face = 0; face < 6; ++face) {
+                for (int y = 0; y < face_ht; y += tile) {
+                    for (int x = 0; x < face_wd; x += tile) {
+                        Tile t;
+                        t.face_ = face;
+                        t.x_ = x;
+                        t.y_ = y;
+                        t.wd_ = std::min(tile, face_wd - x);
+                        t.ht_ = std::min(tile, face_ht - y);
+                        findRows(t);
+                        span = std::max(span, t.last_ - t.first_ + 1);
+                        tiles.push_back(t);
+                    }
+                }
+            }
+            std::sort(tiles.begin(), tiles.end(), [](const Tile &a, const Tile &b) noexcept {
+                return a.last_ < b.last_;
+            });
+        }
+
+        /*
+        latitude has no extremes inside a face.
+        except the poles at the centers of the top and bottom faces.
+        so check the edges of the tile.
+        and the pole.
+        */
+        void findRows(
+            Tile &t
+        ) noexcept {
+            auto x0 = 4 * t.x_;
+            auto y0 = 4 * t.y_;
+            auto x1 = 4 * (t.x_ + t.wd_) - 1;
+            auto y1 = 4 * (t.y_ + t.ht_) - 1;
+            t.first_ = src_ht_;
+            t.last_ = -1;
+            auto add = [&t](Coords c) noexcept {
+                t.first_ = std::min(t.first_, c.y_);
+                t.last_ = std::max(t.last_, c.y_);
+            };
+            for (int x = x0; x <= x1; ++x) {
+                add(project(t.face_, x, y0));
+                add(project(t.face_, x, y1));
+            }
+            for (int y = y0; y <= y1; ++y) {
+                add(project(t.face_, x0, y));
+                add(project(t.face_, x1, y));
+            }
+
+            auto cf = g_cube_faces[t.face_];
+            auto tl = g_cube_vertexes[cf.tl_];
+            auto br = g_cube_vertexes[cf.br_];
+            auto face_wd = out_wd_ / 3;
+            auto face_ht = out_ht_ / 2;
+            bool has_pole = (2*face_wd >= x0 && 2*face_wd <= x1 + 1
+                && 2*face_ht >= y0 && 2*face_ht <= y1 + 1);
+            if (has_pole && tl.y_ == br.y_) {
+                if (tl.y_ > 0.0) {
+                    t.first_ = 0;
+                } else {
+                    t.last_ = src_ht_ - 1;
+                }
+            }
+        }
     };
 }
 
@@ -319,7 +603,12 @@ int main(
 
     Convert cvt;
     auto good = cvt.parseOptions(argc, argv);
-    if (good) {
+    if (good && cvt.tiled_mb_ > 0) {
+        if (cvt.sharpen_ > 0.0) {
+            LOG("Sharpen is not supported in tiled mode.");
+        }
+        cvt.convertTiled();
+    } else if (good) {
         good = cvt.inpng_.read(cvt.input_filename_);
 
         // out width is 3/4 in width.
@@ -330,6 +619,9 @@ int main(
         int ht = (cvt.inpng_.ht_ + 1) / 2 * 2;
         cvt.outpng_.init(wd, ht);
         cvt.copyAllFaces();
+        if (cvt.sharpen_ > 0.0) {
+            sharpen::cubeStrips(cvt.outpng_, cvt.sharpen_, kSharpenSigma);
+        }
         cvt.outpng_.write(cvt.output_filename_);
     }
 
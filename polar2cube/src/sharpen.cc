@@ -0,0 +1,217 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+unsharp mask for cube textures.
+
+sharpened = original + amount * (original - blurred)
+
+the strip is split into planar float r g b.
+so every pass is a multiply-add over contiguous floats.
+which the compiler turns into simd.
+the horizontal pass runs over a copy of the row padded at both ends.
+the vertical pass adds whole rows.
+edges are clamped to the strip.
+**/
+
+#include "sharpen.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+    class Strip {
+    public:
+        Strip() = default;
+        Strip(const Strip &) = delete;
+        ~Strip() = default;
+
+        int wd_ = 0;
+        int ht_ = 0;
+        int stride_ = 0;
+        png_byte *data_ = nullptr;
+        float amount_ = 0.0f;
+        int radius_ = 0;
+        std::vector<float> weights_;
+        std::vector<float> planes_[3];
+        std::vector<float> blurred_;
+        std::vector<float> temp_;
+        std::vector<float> padded_;
+
+        void init(
+            Png &png,
+            int y0,
+            int ht,
+            double amount,
+            double sigma
+        ) noexcept {
+            wd_ = png.wd_;
+            ht_ = ht;
+            stride_ = png.stride_;
+            data_ = png.data_ + y0 * png.stride_;
+            amount_ = float(amount / 100.0);
+
+            // normalized gaussian out to 3 sigma.
+            radius_ = std::max(1, int(std::ceil(3.0 * sigma)));
+            weights_.resize(2*radius_+1);
+            double sum = 0.0;
+            for (int k = -radius_; k <= radius_; ++k) {
+                auto w = std::exp(- double(k*k) / (2.0*sigma*sigma));
+                weights_[k+radius_] = float(w);
+                sum += w;
+            }
+            for (auto& w : weights_) {
+                w = float(double(w) / sum);
+            }
+        }
+
+        void run() noexcept {
+            int size = wd_ * ht_;
+            for (int c = 0; c < 3; ++c) {
+                planes_[c].resize(size);
+            }
+            blurred_.resize(size);
+            temp_.resize(size);
+            padded_.resize(wd_ + 2*radius_);
+
+            split();
+            for (int c = 0; c < 3; ++c) {
+                blurHorz(planes_[c].data(), temp_.data());
+                blurVert(temp_.data(), blurred_.data());
+                unsharp(planes_[c].data(), blurred_.data());
+            }
+            merge();
+        }
+
+        void split() noexcept {
+            auto r = planes_[0].data();
+            auto g = planes_[1].data();
+            auto b = planes_[2].data();
+            auto row = data_;
+            for (int y = 0; y < ht_; ++y, row += stride_) {
+                auto src = row;
+                for (int x = 0; x < wd_; ++x, src += 3) {
+                    *r++ = float(src[0]);
+                    *g++ = float(src[1]);
+                    *b++ = float(src[2]);
+                }
+            }
+        }
+
+        void blurHorz(
+            const float *src,
+            float *dst
+        ) noexcept {
+            auto pad = padded_.data();
+            for (int y = 0; y < ht_; ++y, src += wd_, dst += wd_) {
+                for (int k = 0; k < radius_; ++k) {
+                    pad[k] = src[0];
+                    pad[radius_+wd_+k] = src[wd_-1];
+                }
+                std::memcpy(pad + radius_, src, sizeof(float)*wd_);
+
+                std::memset(dst, 0, sizeof(float)*wd_);
+                for (int k = 0; k <= 2*radius_; ++k) {
+                    auto w = weights_[k];
+                    auto in = pad + k;
+                    for (int x = 0; x < wd_; ++x) {
+                        dst[x] += w * in[x];
+                    }
+                }
+            }
+        }
+
+        void blurVert(
+            const float *src,
+            float *dst
+        ) noexcept {
+            for (int y = 0; y < ht_; ++y, dst += wd_) {
+                std::memset(dst, 0, sizeof(float)*wd_);
+                for (int k = -radius_; k <= radius_; ++k) {
+                    auto w = weights_[k+radius_];
+                    int yk = std::min(std::max(y + k, 0), ht_ - 1);
+                    auto in = src + yk * wd_;
+                    for (int x = 0; x < wd_; ++x) {
+                        dst[x] += w * in[x];
+                    }
+                }
+            }
+        }
+
+        void unsharp(
+            float *plane,
+            const float *blurred
+        ) noexcept {
+            int size = wd_ * ht_;
+            auto amount = amount_;
+            for (int i = 0; i < size; ++i) {
+                auto v = plane[i] + amount * (plane[i] - blurred[i]);
+                plane[i] = std::min(std::max(v, 0.0f), 255.0f);
+            }
+        }
+
+        void merge() noexcept {
+            auto r = planes_[0].data();
+            auto g = planes_[1].data();
+            auto b = planes_[2].data();
+            auto row = data_;
+            for (int y = 0; y < ht_; ++y, row += stride_) {
+                auto dst = row;
+                for (int x = 0; x < wd_; ++x, dst += 3) {
+                    dst[0] = (png_byte) std::lround(*r++);
+                    dst[1] = (png_byte) std::lround(*g++);
+                    dst[2] = (png_byte) std::lround(*b++);
+                }
+            }
+        }
+    };
+
+    class StripWorker : public agm::Thread {
+    public:
+        StripWorker(
+            Strip *strip
+        ) noexcept :
+            agm::Thread("StripWorker"),
+            strip_(strip) {
+        }
+
+        virtual ~StripWorker() = default;
+
+        Strip *strip_;
+
+        /** one strip then done. **/
+        virtual void run() noexcept {
+            strip_->run();
+        }
+    };
+}
+
+void sharpen::cubeStrips(
+    Png &png,
+    double amount,
+    double sigma
+) noexcept {
+    LOG("amount=" << amount << " sigma=" << sigma);
+
+    // the faces are stacked two high.
+    auto ht = png.ht_ / 2;
+    Strip strips[2];
+    strips[0].init(png, 0, ht, amount, sigma);
+    strips[1].init(png, ht, png.ht_ - ht, amount, sigma);
+
+    // the master thread does the top strip.
+    std::vector<agm::Thread *> threads;
+    std::vector<agm::Container *> containers;
+    threads.push_back(new(std::nothrow) StripWorker(&strips[1]));
+    agm::Thread::startAll(threads, containers);
+    strips[0].run();
+    agm::Thread::stopAll(threads, containers);
+}
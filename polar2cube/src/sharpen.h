@@ -0,0 +1,30 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+unsharp mask for cube textures.
+
+the cube texture is two strips of three faces.
+left-front-right on top. top-back-bottom on the bottom.
+the pixels are contiguous within a strip but not across strips.
+so each strip is sharpened on its own.
+otherwise they'll bleed into each other.
+
+the blur is a separable gaussian.
+the strips are sharpened in parallel.
+**/
+
+#include <common/png.h>
+
+
+namespace sharpen {
+    /*
+    amount is in percent.
+    50 looks about the same as gimp filter enhance sharpen 50.
+    sigma is the width of the gaussian blur in pixels.
+    */
+    void cubeStrips(Png &png, double amount, double sigma) noexcept;
+}
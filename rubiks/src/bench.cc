@@ -0,0 +1,129 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+solve random cubes without a window.
+**/
+
+#include "bench.h"
+#include "twophase.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+namespace {
+    /*
+    the centers may be turned.
+    nobody can see that.
+    */
+    bool isHome(
+        const CubeState& state
+    ) noexcept {
+        for (int i = 0; i < kNumCubes; ++i) {
+            if (state.pieces_[i].index_ != i) {
+                return false;
+            }
+        }
+        CubieCube cube;
+        int rotation = 0;
+        auto good = cube.fromState(state, &rotation);
+        return good && cube.isSolved() && rotation == 0;
+    }
+}
+
+bool SolverBench::run() noexcept {
+    MoveTables move_tables;
+    move_tables.init();
+    PruneTables prune_tables;
+    auto good = false;
+    if (tables_) {
+        good = prune_tables.load(tables_);
+    }
+    if (good == false) {
+        prune_tables.init(move_tables);
+    }
+    TwoPhase two_phase(move_tables, prune_tables);
+    two_phase.init(threads_);
+
+    std::default_random_engine ran_eng(seed_);
+    std::uniform_real_distribution<> ran_turn(0.0f, 1.0f);
+
+    int nsolved = 0;
+    int nfailed = 0;
+    int total_length = 0;
+    int max_length = 0;
+    long long total_nodes = 0;
+    long long max_nodes = 0;
+    long long total_us = 0;
+    long long max_us = 0;
+    std::vector<int> solution;
+    std::vector<const StateChange *> changes;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < count_; ++n) {
+        CubeState state;
+        state.reset();
+        const MixUp *mix_up = g_mixup_all;
+        for (int i = 0; i < scramble_length_; ++i) {
+            auto change = mixUp(mix_up, ran_turn(ran_eng));
+            changeState(change, state, state);
+        }
+
+        CubieCube cube;
+        int rotation = 0;
+        cube.fromState(state, &rotation);
+        auto solve_start = std::chrono::steady_clock::now();
+        auto found = two_phase.solve(cube, solution);
+        auto elapsed = std::chrono::steady_clock::now() - solve_start;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+        // play the solution back as key presses.
+        changes.clear();
+        if (found) {
+            movesToChanges(rotation, solution, changes);
+            for (auto change : changes) {
+                changeState(change, state, state);
+            }
+        }
+        if (found == false || isHome(state) == false) {
+            LOG("Failed to solve cube " << n << " found=" << found);
+            ++nfailed;
+            continue;
+        }
+
+        ++nsolved;
+        int length = solution.size();
+        total_length += length;
+        max_length = std::max(max_length, length);
+        total_nodes += two_phase.nodes_;
+        max_nodes = std::max(max_nodes, two_phase.nodes_);
+        total_us += us;
+        max_us = std::max(max_us, (long long) us);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    double seconds = double(us) / 1000000.0;
+
+    LOG("bench cubes=" << count_ << " scramble=" << scramble_length_ << " seed=" << seed_
+        << " threads=" << threads_);
+    LOG("bench solved=" << nsolved << " failed=" << nfailed
+        << " ms=" << us / 1000
+        << " solves/sec=" << (seconds > 0.0 ? nsolved / seconds : 0.0));
+    if (nsolved) {
+        // just the solver. not the scrambles or the playback.
+        double solve_seconds = double(total_us) / 1000000.0;
+        LOG("bench length avg=" << double(total_length) / nsolved << " max=" << max_length);
+        LOG("bench nodes total=" << total_nodes << " avg=" << total_nodes / nsolved
+            << " max=" << max_nodes
+            << " nodes/sec=" << (solve_seconds > 0.0 ? total_nodes / solve_seconds : 0.0));
+        LOG("bench solve ms avg=" << double(total_us) / 1000.0 / nsolved << " max=" << max_us / 1000.0);
+    }
+    return (nfailed == 0);
+}
@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+solve random cubes without a window.
+
+the regression harness for the solver.
+rubiks --bench 100
+
+each cube is scrambled with the same random key presses
+the space bar makes.
+the solution is played back as key presses
+and must return every piece home.
+
+the same seed scrambles the same cubes.
+**/
+
+
+class SolverBench {
+public:
+    SolverBench() = default;
+    SolverBench(const SolverBench &) = delete;
+    ~SolverBench() = default;
+
+    // number of cubes to solve.
+    int count_ = 100;
+    // random key presses per scramble.
+    int scramble_length_ = 200;
+    unsigned seed_ = 1;
+    // search threads. 0 means one per core.
+    int threads_ = 0;
+    // the pruning table file. may be null.
+    const char *tables_ = nullptr;
+
+    // returns false if any cube was not solved.
+    bool run() noexcept;
+};
@@ -0,0 +1,728 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+compact coordinates for the rubik's cube.
+**/
+
+#include "coord.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+#include <cstring>
+
+
+const char *g_move_names[kNumMoves] = {
+    "U", "U2", "U'",
+    "R", "R2", "R'",
+    "F", "F2", "F'",
+    "D", "D2", "D'",
+    "L", "L2", "L'",
+    "B", "B2", "B'"
+};
+
+const int g_phase2_moves[kNumPhase2Moves] = {
+    0, 1, 2, 9, 10, 11, 4, 7, 13, 16
+};
+
+namespace {
+    /*
+    the rotation matrix for each orient.
+    row major.
+    the same products as g_rot_table in render.cc.
+    */
+    const int g_rot[kNumStates][9] = {
+        {+1, +0, +0, +0, +1, +0, +0, +0, +1},  /// 0
+        {+1, +0, +0, +0, +0, -1, +0, +1, +0},  /// 1
+        {+1, +0, +0, +0, -1, +0, +0, +0, -1},  /// 2
+        {+1, +0, +0, +0, +0, +1, +0, -1, +0},  /// 3
+        {+0, +0, +1, +0, +1, +0, -1, +0, +0},  /// 4
+        {+0, +0, +1, +1, +0, +0, +0, +1, +0},  /// 5
+        {+0, +0, +1, +0, -1, +0, +1, +0, +0},  /// 6
+        {+0, +0, +1, -1, +0, +0, +0, -1, +0},  /// 7
+        {-1, +0, +0, +0, +1, +0, +0, +0, -1},  /// 8
+        {-1, +0, +0, +0, +0, +1, +0, +1, +0},  /// 9
+        {-1, +0, +0, +0, -1, +0, +0, +0, +1},  /// 10
+        {-1, +0, +0, +0, +0, -1, +0, -1, +0},  /// 11
+        {+0, +0, -1, +0, +1, +0, +1, +0, +0},  /// 12
+        {+0, +0, -1, -1, +0, +0, +0, +1, +0},  /// 13
+        {+0, +0, -1, +0, -1, +0, -1, +0, +0},  /// 14
+        {+0, +0, -1, +1, +0, +0, +0, -1, +0},  /// 15
+        {+0, -1, +0, +1, +0, +0, +0, +0, +1},  /// 16
+        {+0, -1, +0, +0, +0, -1, +1, +0, +0},  /// 17
+        {+0, -1, +0, -1, +0, +0, +0, +0, -1},  /// 18
+        {+0, -1, +0, +0, +0, +1, -1, +0, +0},  /// 19
+        {+0, +1, +0, -1, +0, +0, +0, +0, +1},  /// 20
+        {+0, +1, +0, +0, +0, -1, -1, +0, +0},  /// 21
+        {+0, +1, +0, +1, +0, +0, +0, +0, -1},  /// 22
+        {+0, +1, +0, +0, +0, +1, +1, +0, +0}   /// 23
+    };
+
+    /// the cubes in the corner and edge slots.
+    const int g_corner_cubes[kNumCorners] = {
+        0, 17, 19, 2, 6, 23, 25, 8
+    };
+    const int g_edge_cubes[kNumEdges] = {
+        1, 9, 18, 11, 7, 14, 24, 16, 3, 20, 22, 5
+    };
+
+    /// the outward normal and the clockwise quarter turn of each face.
+    const int g_face_normals[kNumFaces][3] = {
+        {+0, +1, +0},  /// U
+        {+1, +0, +0},  /// R
+        {+0, +0, +1},  /// F
+        {+0, -1, +0},  /// D
+        {-1, +0, +0},  /// L
+        {+0, +0, -1}   /// B
+    };
+    const int g_face_turns[kNumFaces] = {
+        12, 3, 20, 4, 1, 16
+    };
+
+    class Vec {
+    public:
+        int v_[3];
+
+        bool operator==(const Vec& other) const noexcept {
+            return v_[0] == other.v_[0] && v_[1] == other.v_[1] && v_[2] == other.v_[2];
+        }
+    };
+
+    /// cubes are numbered x then y then z from +1 to -1 skipping the center.
+    Vec cubeXyz(
+        int index
+    ) noexcept {
+        int k = (index < 13) ? index : index + 1;
+        Vec p = {{1 - k / 9, 1 - (k / 3) % 3, 1 - k % 3}};
+        return p;
+    }
+
+    int cubeAt(
+        const Vec& p
+    ) noexcept {
+        int k = 9 * (1 - p.v_[0]) + 3 * (1 - p.v_[1]) + (1 - p.v_[2]);
+        if (k == 13) {
+            return -1;
+        }
+        return (k < 13) ? k : k - 1;
+    }
+
+    Vec rotate(
+        const int *m,
+        const Vec& p
+    ) noexcept {
+        Vec r;
+        for (int i = 0; i < 3; ++i) {
+            r.v_[i] = m[3*i+0] * p.v_[0] + m[3*i+1] * p.v_[1] + m[3*i+2] * p.v_[2];
+        }
+        return r;
+    }
+
+    /// returns the orient of a * b.
+    int multiplyRot(
+        const int *a,
+        const int *b
+    ) noexcept {
+        int m[9];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                m[3*i+j] = a[3*i+0] * b[0+j] + a[3*i+1] * b[3+j] + a[3*i+2] * b[6+j];
+            }
+        }
+        for (int k = 0; k < kNumStates; ++k) {
+            bool same = true;
+            for (int i = 0; i < 9; ++i) {
+                same = same && (m[i] == g_rot[k][i]);
+            }
+            if (same) {
+                return k;
+            }
+        }
+        return -1;
+    }
+
+    void transpose(
+        const int *m,
+        int *t
+    ) noexcept {
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                t[3*j+i] = m[3*i+j];
+            }
+        }
+    }
+
+    int slotOf(
+        const int *cubes,
+        int count,
+        int cube
+    ) noexcept {
+        for (int i = 0; i < count; ++i) {
+            if (cubes[i] == cube) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /// the reference facelet of an edge.
+    /// U or D. else F or B.
+    Vec edgeRef(
+        const Vec& p
+    ) noexcept {
+        Vec r = {{0, 0, 0}};
+        if (p.v_[1]) {
+            r.v_[1] = p.v_[1];
+        } else {
+            r.v_[2] = p.v_[2];
+        }
+        return r;
+    }
+
+    int choose(
+        int n,
+        int k
+    ) noexcept {
+        if (k < 0 || k > n) {
+            return 0;
+        }
+        int result = 1;
+        for (int i = 0; i < k; ++i) {
+            result = result * (n - i) / (i + 1);
+        }
+        return result;
+    }
+
+    /// lehmer code. the identity is 0.
+    int encodePerm(
+        const std::uint8_t *p,
+        int n
+    ) noexcept {
+        int idx = 0;
+        for (int i = 0; i < n; ++i) {
+            int c = 0;
+            for (int j = i + 1; j < n; ++j) {
+                if (p[j] < p[i]) {
+                    ++c;
+                }
+            }
+            idx = idx * (n - i) + c;
+        }
+        return idx;
+    }
+
+    void decodePerm(
+        std::uint32_t idx,
+        std::uint8_t *p,
+        int n,
+        int base
+    ) noexcept {
+        int digits[kNumEdges];
+        for (int i = n - 1; i >= 0; --i) {
+            digits[i] = idx % (n - i);
+            idx /= (n - i);
+        }
+        std::uint8_t avail[kNumEdges];
+        for (int i = 0; i < n; ++i) {
+            avail[i] = base + i;
+        }
+        for (int i = 0; i < n; ++i) {
+            int d = digits[i];
+            p[i] = avail[d];
+            for (int j = d; j < n - i - 1; ++j) {
+                avail[j] = avail[j+1];
+            }
+        }
+    }
+}
+
+void CubieCube::reset() noexcept {
+    for (int i = 0; i < kNumCorners; ++i) {
+        cp_[i] = i;
+        co_[i] = 0;
+    }
+    for (int i = 0; i < kNumEdges; ++i) {
+        ep_[i] = i;
+        eo_[i] = 0;
+    }
+}
+
+/*
+find the rotation of the whole cube from the U and R centers.
+the piece at slot s of the unrotated cube
+is the piece at g*s of the real cube.
+unrotate its orient too.
+*/
+bool CubieCube::fromState(
+    const CubeState& state,
+    int *rotation
+) noexcept {
+    const int kCenterU = 10;
+    const int kCenterR = 4;
+    int pos_u = -1;
+    int pos_r = -1;
+    for (int i = 0; i < kNumCubes; ++i) {
+        auto idx = state.pieces_[i].index_;
+        if (idx == kCenterU) {
+            pos_u = i;
+        } else if (idx == kCenterR) {
+            pos_r = i;
+        }
+    }
+    if (pos_u < 0 || pos_r < 0) {
+        return false;
+    }
+    int g = -1;
+    for (int k = 0; k < kNumStates; ++k) {
+        if (rotate(g_rot[k], cubeXyz(kCenterU)) == cubeXyz(pos_u)
+        &&  rotate(g_rot[k], cubeXyz(kCenterR)) == cubeXyz(pos_r)) {
+            g = k;
+            break;
+        }
+    }
+    if (g < 0) {
+        return false;
+    }
+    int gi[9];
+    transpose(g_rot[g], gi);
+
+    for (int i = 0; i < kNumCorners; ++i) {
+        auto slot = cubeXyz(g_corner_cubes[i]);
+        auto& piece = state.pieces_[cubeAt(rotate(g_rot[g], slot))];
+        auto home = cubeXyz(piece.index_);
+        int c = slotOf(g_corner_cubes, kNumCorners, piece.index_);
+        int orient = multiplyRot(gi, g_rot[piece.orient_]);
+        if (c < 0 || orient < 0 || !(rotate(g_rot[orient], home) == slot)) {
+            return false;
+        }
+        cp_[i] = c;
+
+        /// where did the U or D facelet go?
+        Vec ud = {{0, home.v_[1], 0}};
+        auto v = rotate(g_rot[orient], ud);
+        int twist = 0;
+        if (v.v_[1] == 0) {
+            /// clockwise order depends on the octant.
+            bool x_first = (slot.v_[0] * slot.v_[1] * slot.v_[2] < 0);
+            bool is_x = (v.v_[0] != 0);
+            twist = (is_x == x_first) ? 1 : 2;
+        }
+        co_[i] = twist;
+    }
+
+    for (int i = 0; i < kNumEdges; ++i) {
+        auto slot = cubeXyz(g_edge_cubes[i]);
+        auto& piece = state.pieces_[cubeAt(rotate(g_rot[g], slot))];
+        auto home = cubeXyz(piece.index_);
+        int e = slotOf(g_edge_cubes, kNumEdges, piece.index_);
+        int orient = multiplyRot(gi, g_rot[piece.orient_]);
+        if (e < 0 || orient < 0 || !(rotate(g_rot[orient], home) == slot)) {
+            return false;
+        }
+        ep_[i] = e;
+        auto v = rotate(g_rot[orient], edgeRef(home));
+        eo_[i] = (v == edgeRef(slot)) ? 0 : 1;
+    }
+
+    if (rotation) {
+        *rotation = g;
+    }
+    return true;
+}
+
+void CubieCube::multiply(
+    const CubieCube& b
+) noexcept {
+    CubieCube a = *this;
+    for (int i = 0; i < kNumCorners; ++i) {
+        auto from = b.cp_[i];
+        cp_[i] = a.cp_[from];
+        co_[i] = (a.co_[from] + b.co_[i]) % 3;
+    }
+    for (int i = 0; i < kNumEdges; ++i) {
+        auto from = b.ep_[i];
+        ep_[i] = a.ep_[from];
+        eo_[i] = (a.eo_[from] + b.eo_[i]) % 2;
+    }
+}
+
+bool CubieCube::isSolved() const noexcept {
+    for (int i = 0; i < kNumCorners; ++i) {
+        if (cp_[i] != i || co_[i] != 0) {
+            return false;
+        }
+    }
+    for (int i = 0; i < kNumEdges; ++i) {
+        if (ep_[i] != i || eo_[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CubieCube::getTwist() const noexcept {
+    int twist = 0;
+    for (int i = 0; i < kNumCorners - 1; ++i) {
+        twist = 3 * twist + co_[i];
+    }
+    return twist;
+}
+
+void CubieCube::setTwist(
+    int twist
+) noexcept {
+    int sum = 0;
+    for (int i = kNumCorners - 2; i >= 0; --i) {
+        co_[i] = twist % 3;
+        sum += co_[i];
+        twist /= 3;
+    }
+    co_[kNumCorners - 1] = (3 - sum % 3) % 3;
+}
+
+int CubieCube::getFlip() const noexcept {
+    int flip = 0;
+    for (int i = 0; i < kNumEdges - 1; ++i) {
+        flip = 2 * flip + eo_[i];
+    }
+    return flip;
+}
+
+void CubieCube::setFlip(
+    int flip
+) noexcept {
+    int sum = 0;
+    for (int i = kNumEdges - 2; i >= 0; --i) {
+        eo_[i] = flip % 2;
+        sum += eo_[i];
+        flip /= 2;
+    }
+    eo_[kNumEdges - 1] = sum % 2;
+}
+
+/*
+which 4 of the 12 edge slots hold the slice edges.
+the solved cube is 0.
+*/
+int CubieCube::getSlice() const noexcept {
+    const int kFirstSlice = 8;
+    int slice = 0;
+    int x = 0;
+    for (int j = kNumEdges - 1; j >= 0; --j) {
+        if (ep_[j] >= kFirstSlice) {
+            slice += choose(kNumEdges - 1 - j, x + 1);
+            ++x;
+        }
+    }
+    return slice;
+}
+
+void CubieCube::setSlice(
+    int slice
+) noexcept {
+    const int kFirstSlice = 8;
+    const int kNone = 0xFF;
+    for (int i = 0; i < kNumEdges; ++i) {
+        ep_[i] = kNone;
+    }
+    int x = 4;
+    for (int j = 0; j < kNumEdges; ++j) {
+        int c = choose(kNumEdges - 1 - j, x);
+        if (slice - c >= 0) {
+            ep_[j] = kFirstSlice + 4 - x;
+            slice -= c;
+            --x;
+        }
+    }
+    int other = 0;
+    for (int j = 0; j < kNumEdges; ++j) {
+        if (ep_[j] == kNone) {
+            ep_[j] = other++;
+        }
+    }
+}
+
+int CubieCube::getCornerPerm() const noexcept {
+    return encodePerm(cp_, kNumCorners);
+}
+
+void CubieCube::setCornerPerm(
+    int perm
+) noexcept {
+    decodePerm(perm, cp_, kNumCorners, 0);
+}
+
+int CubieCube::getEdgePerm() const noexcept {
+    return encodePerm(ep_, 8);
+}
+
+void CubieCube::setEdgePerm(
+    int perm
+) noexcept {
+    decodePerm(perm, ep_, 8, 0);
+}
+
+int CubieCube::getSlicePerm() const noexcept {
+    return encodePerm(ep_ + 8, 4);
+}
+
+void CubieCube::setSlicePerm(
+    int perm
+) noexcept {
+    decodePerm(perm, ep_ + 8, 4, 8);
+}
+
+std::uint32_t CubieCube::getAllEdgePerm() const noexcept {
+    return encodePerm(ep_, kNumEdges);
+}
+
+void CubieCube::setAllEdgePerm(
+    std::uint32_t perm
+) noexcept {
+    decodePerm(perm, ep_, kNumEdges, 0);
+}
+
+void PackedCube::pack(
+    const CubieCube& cube
+) noexcept {
+    edges_ = cube.getAllEdgePerm();
+    corners_ = cube.getCornerPerm();
+    twist_ = cube.getTwist();
+    flip_ = cube.getFlip();
+    pad_ = 0;
+}
+
+void PackedCube::unpack(
+    CubieCube& cube
+) const noexcept {
+    cube.setAllEdgePerm(edges_);
+    cube.setCornerPerm(corners_);
+    cube.setTwist(twist_);
+    cube.setFlip(flip_);
+}
+
+MoveTables::MoveTables() noexcept {
+}
+
+MoveTables::~MoveTables() noexcept {
+}
+
+void MoveTables::init() noexcept {
+    /*
+    turn one face of a solved cube.
+    convert it to the cube for the quarter turn.
+    */
+    for (int f = 0; f < kNumFaces; ++f) {
+        auto turn = g_rot[g_face_turns[f]];
+        Vec normal = {{g_face_normals[f][0], g_face_normals[f][1], g_face_normals[f][2]}};
+        CubeState solved;
+        solved.reset();
+        CubeState state = solved;
+        for (int i = 0; i < kNumCubes; ++i) {
+            auto p = cubeXyz(i);
+            int dot = p.v_[0] * normal.v_[0] + p.v_[1] * normal.v_[1] + p.v_[2] * normal.v_[2];
+            if (dot != 1) {
+                continue;
+            }
+            auto& old_piece = solved.pieces_[i];
+            auto& new_piece = state.pieces_[cubeAt(rotate(turn, p))];
+            new_piece.index_ = old_piece.index_;
+            new_piece.orient_ = multiplyRot(turn, g_rot[old_piece.orient_]);
+        }
+        auto& quarter = moves_[3*f];
+        quarter.fromState(state, nullptr);
+        moves_[3*f+1] = quarter;
+        moves_[3*f+1].multiply(quarter);
+        moves_[3*f+2] = moves_[3*f+1];
+        moves_[3*f+2].multiply(quarter);
+    }
+
+    bool is_phase2[kNumMoves] = {false};
+    for (int i = 0; i < kNumPhase2Moves; ++i) {
+        is_phase2[g_phase2_moves[i]] = true;
+    }
+
+    CubieCube a;
+    CubieCube b;
+    twist_.resize(kNumTwist * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumTwist; ++i) {
+        a.setTwist(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            b = a;
+            b.multiply(moves_[m]);
+            twist_[i * kNumMoves + m] = b.getTwist();
+        }
+    }
+
+    flip_.resize(kNumFlip * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumFlip; ++i) {
+        a.setFlip(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            b = a;
+            b.multiply(moves_[m]);
+            flip_[i * kNumMoves + m] = b.getFlip();
+        }
+    }
+
+    slice_.resize(kNumSlice * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumSlice; ++i) {
+        a.setSlice(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            b = a;
+            b.multiply(moves_[m]);
+            slice_[i * kNumMoves + m] = b.getSlice();
+        }
+    }
+
+    corner_perm_.resize(kNumCornerPerm * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumCornerPerm; ++i) {
+        a.setCornerPerm(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            b = a;
+            b.multiply(moves_[m]);
+            corner_perm_[i * kNumMoves + m] = b.getCornerPerm();
+        }
+    }
+
+    /// the other moves take the slice edges out of the slice.
+    edge_perm_.resize(kNumEdgePerm * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumEdgePerm; ++i) {
+        a.setEdgePerm(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            int coord = 0;
+            if (is_phase2[m]) {
+                b = a;
+                b.multiply(moves_[m]);
+                coord = b.getEdgePerm();
+            }
+            edge_perm_[i * kNumMoves + m] = coord;
+        }
+    }
+
+    slice_perm_.resize(kNumSlicePerm * kNumMoves);
+    a.reset();
+    for (int i = 0; i < kNumSlicePerm; ++i) {
+        a.setSlicePerm(i);
+        for (int m = 0; m < kNumMoves; ++m) {
+            int coord = 0;
+            if (is_phase2[m]) {
+                b = a;
+                b.multiply(moves_[m]);
+                coord = b.getSlicePerm();
+            }
+            slice_perm_[i * kNumMoves + m] = coord;
+        }
+    }
+}
+
+namespace {
+    const StateChange *findChange(
+        const char *text
+    ) noexcept {
+        for (auto change = g_change_table; change->symbol_; ++change) {
+            if (std::strcmp(change->text_, text) == 0) {
+                return change;
+            }
+        }
+        return nullptr;
+    }
+
+    /// the orient of the whole cube after the change.
+    int turnWhole(
+        int rotation,
+        const StateChange *change
+    ) noexcept {
+        return change->state_map_[rotation];
+    }
+}
+
+void movesToChanges(
+    int rotation,
+    const std::vector<int>& moves,
+    std::vector<const StateChange *>& changes
+) noexcept {
+    auto a = findChange("A");
+    auto d = findChange("D");
+    auto s = findChange("S");
+    auto w = findChange("W");
+    auto up = findChange("Up");
+    auto dn = findChange("Dn");
+
+    for (auto m : moves) {
+        int face = m / 3;
+        int turns = m % 3 + 1;
+        Vec normal = {{g_face_normals[face][0], g_face_normals[face][1], g_face_normals[face][2]}};
+        auto v = rotate(g_rot[rotation], normal);
+
+        /// bring the face to +x.
+        const StateChange *whole[2] = {nullptr, nullptr};
+        if (v.v_[0] < 0) {
+            whole[0] = d;
+            whole[1] = d;
+        } else if (v.v_[1] > 0) {
+            whole[0] = s;
+        } else if (v.v_[1] < 0) {
+            whole[0] = w;
+        } else if (v.v_[2] > 0) {
+            whole[0] = d;
+        } else if (v.v_[2] < 0) {
+            whole[0] = a;
+        }
+        for (auto change : whole) {
+            if (change) {
+                rotation = turnWhole(rotation, change);
+                changes.push_back(change);
+            }
+        }
+
+        /// Up turns the right face clockwise.
+        if (turns == 3) {
+            changes.push_back(dn);
+        } else {
+            for (int i = 0; i < turns; ++i) {
+                changes.push_back(up);
+            }
+        }
+    }
+
+    /*
+    breadth first search for the shortest way home.
+    */
+    const StateChange *wholes[4] = {a, d, s, w};
+    int prev[kNumStates];
+    const StateChange *via[kNumStates];
+    for (int i = 0; i < kNumStates; ++i) {
+        prev[i] = -1;
+        via[i] = nullptr;
+    }
+    int queue[kNumStates];
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = rotation;
+    prev[rotation] = rotation;
+    while (head < tail && prev[0] < 0) {
+        int r = queue[head++];
+        for (auto change : wholes) {
+            int r1 = turnWhole(r, change);
+            if (prev[r1] < 0) {
+                prev[r1] = r;
+                via[r1] = change;
+                queue[tail++] = r1;
+            }
+        }
+    }
+    const StateChange *path[kNumStates];
+    int npath = 0;
+    for (int r = 0; r != rotation; r = prev[r]) {
+        path[npath++] = via[r];
+    }
+    for (int i = npath - 1; i >= 0; --i) {
+        changes.push_back(path[i]);
+    }
+}
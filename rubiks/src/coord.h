@@ -0,0 +1,190 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+compact coordinates for the rubik's cube.
+
+CubeState is 26 pieces. 208 bytes.
+a move walks the rotation and state maps for every piece.
+that's too slow for a solver.
+
+the centers never move relative to each other.
+so the cube is really 8 corners and 12 edges.
+relative to the centers.
+a corner has a permutation and a twist 0-2.
+an edge has a permutation and a flip 0-1.
+that's the CubieCube.
+
+the pieces are numbered the usual way.
+U is +y. R is +x. F is +z.
+corners: URF UFL ULB UBR DFR DLF DBL DRB
+edges: UR UF UL UB DR DF DL DB FR FL BL BR
+
+the twist of a corner is where its U or D facelet is.
+the flip of an edge is whether its U or D facelet is on the U or D face.
+or its F or B facelet for the middle layer.
+
+the orientations and permutations pack into a few integers.
+corner twist       3^7  =  2187
+edge flip          2^11 =  2048
+slice edges        12c4 =   495  where the FR FL BL BR edges are
+corner permutation 8!   = 40320
+ud edge permutation 8!  = 40320  when the slice edges are in the slice
+slice permutation  4!   =    24  ditto
+edge permutation   12!  = 479001600
+
+the move tables map a coordinate and a move to a new coordinate.
+so a move is one table lookup per coordinate.
+
+there are 18 moves. 6 faces times 3 quarter turns.
+face U R F D L B. quarter turns clockwise looking at the face.
+move = 3*face + turns - 1.
+**/
+
+#include "cube.h"
+
+#include <cstdint>
+#include <vector>
+
+
+const int kNumCorners = 8;
+const int kNumEdges = 12;
+const int kNumFaces = 6;
+const int kNumMoves = 18;
+
+const int kNumTwist = 2187;
+const int kNumFlip = 2048;
+const int kNumSlice = 495;
+const int kNumCornerPerm = 40320;
+const int kNumEdgePerm = 40320;
+const int kNumSlicePerm = 24;
+
+// U R F D L B
+extern const char *g_move_names[kNumMoves];
+
+// the moves that keep the cube in the phase 2 group.
+// U U2 U' D D2 D' R2 F2 L2 B2
+const int kNumPhase2Moves = 10;
+extern const int g_phase2_moves[kNumPhase2Moves];
+
+class CubieCube {
+public:
+    std::uint8_t cp_[kNumCorners];
+    std::uint8_t co_[kNumCorners];
+    std::uint8_t ep_[kNumEdges];
+    std::uint8_t eo_[kNumEdges];
+
+    void reset() noexcept;
+
+    /*
+    convert from the pieces.
+    the whole cube may be turned.
+    rotation is the orient of the whole cube.
+    returns false if the state is not a real cube.
+    */
+    bool fromState(const CubeState& state, int *rotation) noexcept;
+
+    // this = this * b.
+    // apply a move by multiplying by the move's cube.
+    void multiply(const CubieCube& b) noexcept;
+
+    bool isSolved() const noexcept;
+
+    int getTwist() const noexcept;
+    void setTwist(int twist) noexcept;
+    int getFlip() const noexcept;
+    void setFlip(int flip) noexcept;
+    int getSlice() const noexcept;
+    void setSlice(int slice) noexcept;
+    int getCornerPerm() const noexcept;
+    void setCornerPerm(int perm) noexcept;
+    // the first 8 edges must be the ud edges.
+    int getEdgePerm() const noexcept;
+    void setEdgePerm(int perm) noexcept;
+    // the last 4 edges must be the slice edges.
+    int getSlicePerm() const noexcept;
+    void setSlicePerm(int perm) noexcept;
+    // all 12 edges.
+    std::uint32_t getAllEdgePerm() const noexcept;
+    void setAllEdgePerm(std::uint32_t perm) noexcept;
+};
+
+/*
+the whole cube in 12 bytes.
+*/
+class PackedCube {
+public:
+    std::uint32_t edges_;
+    std::uint16_t corners_;
+    std::uint16_t twist_;
+    std::uint16_t flip_;
+    std::uint16_t pad_;
+
+    void pack(const CubieCube& cube) noexcept;
+    void unpack(CubieCube& cube) const noexcept;
+
+    bool operator==(const PackedCube& other) const noexcept {
+        return edges_ == other.edges_ && corners_ == other.corners_
+            && twist_ == other.twist_ && flip_ == other.flip_;
+    }
+};
+
+/*
+coordinate x move to coordinate.
+the phase 2 tables only have entries for the phase 2 moves.
+about 4 MB.
+*/
+class MoveTables {
+public:
+    MoveTables() noexcept;
+    MoveTables(const MoveTables &) = delete;
+    ~MoveTables() noexcept;
+
+    // the cube for each move.
+    CubieCube moves_[kNumMoves];
+
+    std::vector<std::uint16_t> twist_;
+    std::vector<std::uint16_t> flip_;
+    std::vector<std::uint16_t> slice_;
+    std::vector<std::uint16_t> corner_perm_;
+    std::vector<std::uint16_t> edge_perm_;
+    std::vector<std::uint16_t> slice_perm_;
+
+    // takes about a tenth of a second.
+    void init() noexcept;
+
+    int twist(int coord, int move) const noexcept {
+        return twist_[coord * kNumMoves + move];
+    }
+    int flip(int coord, int move) const noexcept {
+        return flip_[coord * kNumMoves + move];
+    }
+    int slice(int coord, int move) const noexcept {
+        return slice_[coord * kNumMoves + move];
+    }
+    int cornerPerm(int coord, int move) const noexcept {
+        return corner_perm_[coord * kNumMoves + move];
+    }
+    int edgePerm(int coord, int move) const noexcept {
+        return edge_perm_[coord * kNumMoves + move];
+    }
+    int slicePerm(int coord, int move) const noexcept {
+        return slice_perm_[coord * kNumMoves + move];
+    }
+};
+
+/*
+convert face turns to key presses.
+rotation is the orient of the whole cube. see fromState.
+A D S W turn the whole cube to bring each face to the right.
+then Up or Dn turns it.
+then the whole cube turns home.
+*/
+void movesToChanges(
+    int rotation,
+    const std::vector<int>& moves,
+    std::vector<const StateChange *>& changes
+) noexcept;
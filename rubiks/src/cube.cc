@@ -0,0 +1,178 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+the state of the rubik's cube.
+**/
+
+#include "cube.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+#if !defined(XK_MISCELLANY)
+#define XK_MISCELLANY 1
+#endif
+#include <X11/keysymdef.h>
+
+
+namespace {
+    const int g_mapxp[kNumCubes] = {
+        2,  5,  8,  1,  4,  7,  0,  3,  6,
+        11, 13, 16, 10,     15, 9,  12, 14,
+        19, 22, 25, 18, 21, 24, 17, 20, 23
+    };
+    const int g_mapxm[kNumCubes] = {
+        6,  3,  0,  7,  4,  1,  8,  5,  2,
+        14, 12, 9,  15,     10, 16, 13, 11,
+        23, 20, 17, 24, 21, 18, 25, 22, 19
+    };
+    const int g_mapyp[kNumCubes] = {
+        17, 9,  0,  20, 12, 3,  23, 14, 6,
+        18, 10, 1,  21,     4,  24, 15, 7,
+        19, 11, 2,  22, 13, 5,  25, 16, 8
+    };
+    const int g_mapym[kNumCubes] = {
+        2,  11, 19, 5,  13, 22, 8,  16, 25,
+        1,  10, 18, 4,      21, 7,  15, 24,
+        0,  9,  17, 3,  12, 20, 6,  14, 23
+    };
+    const int g_mapzp[kNumCubes] = {
+        6,  7,  8, 14, 15, 16, 23, 24, 25,
+        3,  4,  5, 12,     13, 20, 21, 22,
+        0,  1,  2, 9,  10, 11, 17, 18, 19
+    };
+    const int g_mapzm[kNumCubes] = {
+        17, 18, 19, 9,  10, 11, 0,  1,  2,
+        20, 21, 22, 12,     13, 3,  4,  5,
+        23, 24, 25, 14, 15, 16, 6,  7,  8
+    };
+    const int g_state_xp[kNumStates] = {
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, 17, 18, 19, 16, 21, 22, 23, 20
+    };
+    const int g_state_xm[kNumStates] = {
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 19, 16, 17, 18, 23, 20, 21, 22
+    };
+    const int g_state_yp[kNumStates] = {
+        4, 21, 14, 19, 8, 22, 2, 18, 12, 23, 6, 17, 0, 20, 10, 16, 5, 1, 13, 9, 7, 11, 15, 3
+    };
+    const int g_state_ym[kNumStates] = {
+        12, 17, 6, 23, 0, 16, 10, 20, 4, 19, 14, 21, 8, 18, 2, 22, 15, 11, 7, 3, 13, 1, 5, 9
+    };
+    const int g_state_zp[kNumStates] = {
+        16, 5, 22, 15, 19, 9, 23, 3, 18, 13, 20, 7, 17, 1, 21, 11, 10, 6, 2, 14, 0, 4, 8, 12
+    };
+    const int g_state_zm[kNumStates] = {
+        20, 13, 18, 7, 21, 1, 17, 11, 22, 5, 16, 15, 23, 9, 19, 3, 0, 12, 8, 4, 10, 14, 2, 6
+    };
+
+    const int kUp = XK_Up;
+    const int kDn = XK_Down;
+
+    const StateChange g_change_a  = {'a', "A",  g_mapym, g_state_ym, {+0.0f, -1.0f, +0.0f}, kNumCubes};
+    const StateChange g_change_d  = {'d', "D",  g_mapyp, g_state_yp, {+0.0f, +1.0f, +0.0f}, kNumCubes};
+    const StateChange g_change_s  = {'s', "S",  g_mapzm, g_state_zm, {+0.0f, +0.0f, -1.0f}, kNumCubes};
+    const StateChange g_change_w  = {'w', "W",  g_mapzp, g_state_zp, {+0.0f, +0.0f, +1.0f}, kNumCubes};
+    const StateChange g_change_up = {kUp, "Up", g_mapxm, g_state_xm, {-1.0f, +0.0f, +0.0f}, kNumFaceCubes};
+    const StateChange g_change_dn = {kDn, "Dn", g_mapxp, g_state_xp, {+1.0f, +0.0f, +0.0f}, kNumFaceCubes};
+    const StateChange g_change_na = {0,   "",   nullptr, nullptr,    {+0.0f, +0.0f, +0.0f}, 0};
+
+    extern const MixUp g_mixup_up2[];
+    extern const MixUp g_mixup_a2[];
+    extern const MixUp g_mixup_w2[];
+    extern const MixUp g_mixup_ad_sw[];
+    extern const MixUp g_mixup_ad_updn[];
+    extern const MixUp g_mixup_sw_updn[];
+}
+
+const StateChange g_change_table[] = {
+    g_change_a, g_change_d, g_change_s, g_change_w, g_change_up, g_change_dn, g_change_na
+};
+
+const MixUp g_mixup_all[] = {
+    {1.0f/9.0f, &g_change_up, g_mixup_ad_sw},
+    {1.0f/9.0f, &g_change_dn, g_mixup_ad_sw},
+    {1.0f/9.0f, &g_change_up, g_mixup_up2},
+    {1.0f/9.0f, &g_change_a,  g_mixup_sw_updn},
+    {1.0f/9.0f, &g_change_d,  g_mixup_sw_updn},
+    {1.0f/9.0f, &g_change_a,  g_mixup_a2},
+    {1.0f/9.0f, &g_change_w,  g_mixup_ad_updn},
+    {1.0f/9.0f, &g_change_s,  g_mixup_ad_updn},
+    {2.0f,      &g_change_w,  g_mixup_w2},
+};
+
+namespace {
+    const MixUp g_mixup_up2[] = {
+        {2.0f,      &g_change_up, g_mixup_ad_sw},
+    };
+    const MixUp g_mixup_a2[] = {
+        {2.0f,      &g_change_a,  g_mixup_sw_updn},
+    };
+    const MixUp g_mixup_w2[] = {
+        {2.0f,      &g_change_w,  g_mixup_ad_updn},
+    };
+    const MixUp g_mixup_ad_sw[] = {
+        {1.0f/6.0f, &g_change_a,  g_mixup_sw_updn},
+        {1.0f/6.0f, &g_change_d,  g_mixup_sw_updn},
+        {1.0f/6.0f, &g_change_a,  g_mixup_a2},
+        {1.0f/6.0f, &g_change_w,  g_mixup_ad_updn},
+        {1.0f/6.0f, &g_change_s,  g_mixup_ad_updn},
+        {2.0f,      &g_change_w,  g_mixup_w2},
+    };
+    const MixUp g_mixup_ad_updn[] = {
+        {1.0f/6.0f, &g_change_up, g_mixup_ad_sw},
+        {1.0f/6.0f, &g_change_dn, g_mixup_ad_sw},
+        {1.0f/6.0f, &g_change_up, g_mixup_up2},
+        {1.0f/6.0f, &g_change_a,  g_mixup_sw_updn},
+        {1.0f/6.0f, &g_change_d,  g_mixup_sw_updn},
+        {2.0f,      &g_change_a,  g_mixup_a2},
+    };
+    const MixUp g_mixup_sw_updn[] = {
+        {1.0f/6.0f, &g_change_up, g_mixup_ad_sw},
+        {1.0f/6.0f, &g_change_dn, g_mixup_ad_sw},
+        {1.0f/6.0f, &g_change_up, g_mixup_up2},
+        {1.0f/6.0f, &g_change_w,  g_mixup_ad_updn},
+        {1.0f/6.0f, &g_change_s,  g_mixup_ad_updn},
+        {2.0f,      &g_change_w,  g_mixup_w2},
+    };
+}
+
+void CubeState::reset() noexcept {
+    for (int i = 0; i < kNumCubes; ++i) {
+        auto& s = pieces_[i];
+        s.index_ = i;
+        s.orient_ = 0;
+    }
+}
+
+void changeState(
+    const StateChange *change,
+    const CubeState& old_state,
+    CubeState& new_state
+) noexcept {
+    CubeState temp_state = old_state;
+    int ncubes = change->count_;
+    for (int i = 0; i < ncubes; ++i) {
+        int new_idx = change->rotation_map_[i];
+        auto& s = old_state.pieces_[new_idx];
+        int moved_idx = s.orient_;
+        int rot_idx = change->state_map_[moved_idx];
+        auto& ns = temp_state.pieces_[i];
+        ns.index_ = s.index_;
+        ns.orient_ = rot_idx;
+    }
+    new_state = temp_state;
+}
+
+const StateChange *mixUp(
+    const MixUp *&mix_up,
+    float ran
+) noexcept {
+    for (auto dist = mix_up; ; ++dist) {
+        if (ran < dist->prob_) {
+            mix_up = dist->next_;
+            return dist->change_;
+        }
+        ran -= dist->prob_;
+    }
+}
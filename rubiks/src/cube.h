@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+the state of the rubik's cube.
+
+the rubik's cube is a 3x3x3 stack of identical colored cubes.
+the cubes are numbered by their home position.
+cubes 0-8 are the x=+1 face.
+the center cube is not numbered.
+
+a piece is the cube at a position.
+index is the piece's home position.
+orient is the rotation of the piece. see g_state_xp.
+
+the changes are the moves the keys make.
+a d s w turn the whole cube.
+up dn turn the x=+1 face.
+
+no opengl here.
+the solver threads use this too.
+**/
+
+
+const int kNumFaceCubes = 9;
+const int kNumCubes = 26;
+const int kNumStates = 24;
+
+class StateChange {
+public:
+    int symbol_;
+    const char *text_;
+    const int *rotation_map_;
+    const int *state_map_;
+    float axis_[3];
+    int count_;
+};
+
+// terminated by a change with symbol 0.
+extern const StateChange g_change_table[];
+
+class MixUp {
+public:
+    float prob_;
+    const StateChange *change_;
+    const MixUp *next_;
+};
+
+// randomize the cube without immediately undoing a move.
+extern const MixUp g_mixup_all[];
+
+// pick a change from the distribution.
+// ran is uniform in [0,1).
+// mix_up moves to the next distribution.
+const StateChange *mixUp(const MixUp *&mix_up, float ran) noexcept;
+
+class PieceState {
+public:
+    int index_;
+    int orient_;
+};
+
+class CubeState {
+public:
+    PieceState pieces_[kNumCubes];
+
+    // every piece is home.
+    void reset() noexcept;
+};
+
+// old and new may be the same.
+void changeState(
+    const StateChange *change,
+    const CubeState& old_state,
+    CubeState& new_state
+) noexcept;
+
@@ -7,14 +7,25 @@ rubiks cube example.
 **/
 
 #include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/cmd_line.h>
 #include <aggiornamento/log.h>
 #include <aggiornamento/master.h>
 
+#include "bench.h"
+#include "coord.h"
+#include "prune.h"
 #include "window.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 
 namespace {
 	const auto kFrameTimeMS = 1000/60;
+	const auto kHeadlessFrames = 24*60;
+	const auto kDefaultTables = "rubiks.prune";
 
     class Rubiks {
     public:
@@ -23,23 +34,179 @@ namespace {
         ~Rubiks() = default;
 
         RubiksWindow *window_ = nullptr;
+        bool headless_ = false;
+        int max_frames_ = kHeadlessFrames;
+        const char *capture_ = nullptr;
+        bool stats_ = false;
+        bool overlay_ = false;
+        const char *tables_ = kDefaultTables;
+        bool gen_tables_ = false;
+        int bench_ = 0;
+        unsigned seed_ = 1;
+        int threads_ = 0;
+        int exit_code_ = 0;
+
+        bool parseOptions(
+            int argc,
+            char *argv[]
+        ) noexcept {
+            agm::CmdLineOptions::LongFormat cmd_line_options[] = {
+                {"help",     '?'},
+                {"headless", 'H'},
+                {"frames",   'n'},
+                {"capture",  'c'},
+                {"stats",    'S'},
+                {"overlay",  'O'},
+                {"tables",   't'},
+                {"gen-tables", 'G'},
+                {"bench",    'b'},
+                {"seed",     's'},
+                {"threads",  'j'},
+                {nullptr, 0}
+            };
+            agm::CmdLineOptions clo(argc, argv, "?Hn:c:SOt:Gb:s:j:", cmd_line_options);
+            while (clo.get()) {
+                switch (clo.option_) {
+                case '?':
+                    showHelp();
+                    return false;
+
+                case 'H':
+                    headless_ = true;
+                    break;
+
+                case 'n':
+                    max_frames_ = std::atoi(clo.value_);
+                    break;
+
+                case 'S':
+                    stats_ = true;
+                    break;
+
+                case 'O':
+                    stats_ = true;
+                    overlay_ = true;
+                    break;
+
+                case 't':
+                    tables_ = clo.value_;
+                    break;
+
+                case 'G':
+                    gen_tables_ = true;
+                    break;
+
+                case 'b':
+                    bench_ = std::atoi(clo.value_);
+                    break;
+
+                case 's':
+                    seed_ = std::atoi(clo.value_);
+                    break;
+
+                case 'j':
+                    threads_ = std::atoi(clo.value_);
+                    break;
+
+                case 'c':
+                    capture_ = clo.value_;
+                    if (std::strcmp(capture_, "-") == 0) {
+                        // stdout is the video. keep the log out of it.
+                        agm::log::setConsole(&std::cerr);
+                    }
+                    break;
+                }
+            }
+            if (clo.error_) {
+                showHelp();
+                return false;
+            }
+            LOG("headless=" << headless_ << " frames=" << max_frames_
+                << " capture=" << (capture_ ? capture_ : "none")
+                << " stats=" << stats_ << " overlay=" << overlay_
+                << " tables=" << tables_ << " gen-tables=" << gen_tables_
+                << " bench=" << bench_ << " seed=" << seed_ << " threads=" << threads_);
+            return true;
+        }
+
+        void showHelp() noexcept {
+            LOG("Usage: " AGM_TARGET_NAME " [options]");
+            LOG("  --help     -?  show this message");
+            LOG("  --headless -H  render offscreen as fast as possible");
+            LOG("  --frames   -n  number of frames to render headless");
+            LOG("  --capture  -c  capture frames to file.y4m or - for stdout");
+            LOG("                 anything else is a png file prefix");
+            LOG("  --stats    -S  log frame timing and draw stats");
+            LOG("  --overlay  -O  stats plus frame times on screen");
+            LOG("  --tables   -t  solver pruning table file. default " << kDefaultTables);
+            LOG("  --gen-tables -G  build the pruning table file and exit");
+            LOG("  --bench    -b  solve this many random cubes without a window");
+            LOG("  --seed     -s  random seed for the bench");
+            LOG("  --threads  -j  bench search threads. default one per core");
+        }
 
         void run() noexcept {
+            if (gen_tables_) {
+                genTables();
+                return;
+            }
+            if (bench_ > 0) {
+                SolverBench bench;
+                bench.count_ = bench_;
+                bench.seed_ = seed_;
+                bench.threads_ = threads_;
+                bench.tables_ = tables_;
+                auto good = bench.run();
+                exit_code_ = good ? 0 : 1;
+                return;
+            }
             window_ = RubiksWindow::create();
-            window_->init();
+            window_->init(headless_, capture_, stats_, overlay_, tables_);
             runLoop();
             window_->exit();
             delete window_;
         }
 
+        /*
+        no window.
+        the solver maps the file the next time it starts.
+        */
+        void genTables() noexcept {
+            MoveTables move_tables;
+            move_tables.init();
+            PruneTables prune_tables;
+            prune_tables.init(move_tables);
+            prune_tables.save(tables_);
+        }
+
+        /*
+        every frame is one fixed time step.
+        the window sleeps to run at about 60 fps.
+        headless runs as fast as it can.
+        */
         void runLoop() noexcept {
+            auto start = std::chrono::steady_clock::now();
+            int nframes = 0;
             for(;;) {
                 auto is_done = agm::master::isDone();
                 if (is_done) {
                     break;
                 }
-                //agm::sleep::milliseconds(kFrameTimeMS);
+                if (headless_) {
+                    if (nframes >= max_frames_) {
+                        break;
+                    }
+                } else {
+                    //agm::sleep::milliseconds(kFrameTimeMS);
+                }
                 window_->run();
+                ++nframes;
+            }
+            if (headless_) {
+                auto stop = std::chrono::steady_clock::now();
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+                LOG("frames=" << nframes << " ms=" << ms
+                    << " fps=" << (ms ? 1000.0 * nframes / ms : 0.0));
             }
         }
     };
@@ -48,13 +215,13 @@ namespace {
 int main(
     int argc, char *argv[]
 ) noexcept {
-    (void) argc;
-    (void) argv;
-
     agm::log::init(AGM_TARGET_NAME ".log");
 
     Rubiks rubiks;
-    rubiks.run();
+    auto good = rubiks.parseOptions(argc, argv);
+    if (good) {
+        rubiks.run();
+    }
 
-    return 0;
+    return rubiks.exit_code_;
 }
@@ -0,0 +1,488 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+pruning tables for the two phase solver.
+
+master thread               worker threads
+--------------------        --------------------
+for each table
+    fill with unknown
+    solved is 0
+    for each depth
+        post pass
+                            wait for pass
+        take chunks         take chunks
+            entries at depth    entries at depth
+            mark unknown        mark unknown
+            neighbors           neighbors
+                            done
+        wait for workers
+        stop when nothing new
+
+two entries share a byte.
+and two threads may find the same neighbor.
+so entries are set with compare and swap.
+
+the file is a 64 byte header followed by the tables.
+each table starts on a 64 byte boundary.
+**/
+
+#include "prune.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    const char kMagic[8] = {'R', 'U', 'B', 'I', 'K', 'S', 'P', 'T'};
+    // change this when the coordinates or the moves change.
+    const std::uint32_t kVersion = 1;
+    const int kNumTables = 4;
+    const int kAlign = 64;
+    const std::uint8_t kUnknown = 0xF;
+    const int kChunkEntries = 16 * 1024;
+    const int kMaxWorkers = 8;
+
+    const int g_table_entries[kNumTables] = {
+        kNumTwist * kNumSlice,
+        kNumFlip * kNumSlice,
+        kNumCornerPerm * kNumSlicePerm,
+        kNumEdgePerm * kNumSlicePerm
+    };
+
+    class Header {
+    public:
+        char magic_[8];
+        std::uint32_t version_;
+        std::uint32_t num_tables_;
+        std::uint32_t entries_[kNumTables];
+        std::uint32_t pad_[8];
+    };
+    static_assert(sizeof(Header) == kAlign, "the tables must stay aligned.");
+
+    std::size_t tableBytes(
+        int entries
+    ) noexcept {
+        std::size_t bytes = (entries + 1) / 2;
+        return (bytes + kAlign - 1) / kAlign * kAlign;
+    }
+
+    std::size_t dataBytes() noexcept {
+        std::size_t bytes = 0;
+        for (int i = 0; i < kNumTables; ++i) {
+            bytes += tableBytes(g_table_entries[i]);
+        }
+        return bytes;
+    }
+
+    /// other threads may be setting the other entry in the byte.
+    int getEntry(
+        std::uint8_t *table,
+        int index
+    ) noexcept {
+        std::atomic_ref<std::uint8_t> ref(table[index >> 1]);
+        auto byte = ref.load(std::memory_order_relaxed);
+        return (byte >> ((index & 1) * 4)) & 0xF;
+    }
+
+    /// returns true if this thread set it.
+    bool setIfUnknown(
+        std::uint8_t *table,
+        int index,
+        int value
+    ) noexcept {
+        std::atomic_ref<std::uint8_t> ref(table[index >> 1]);
+        int shift = (index & 1) * 4;
+        auto old = ref.load(std::memory_order_relaxed);
+        for(;;) {
+            if (((old >> shift) & 0xF) != kUnknown) {
+                return false;
+            }
+            std::uint8_t nv = (old & ~(0xF << shift)) | (value << shift);
+            if (ref.compare_exchange_weak(old, nv, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+}
+
+/*
+one pass of the breadth first search.
+hands out chunks of entries to the workers.
+*/
+class PruneBuild : public agm::Container {
+public:
+    PruneBuild() noexcept :
+        agm::Container("PruneBuild") {
+    }
+
+    virtual ~PruneBuild() = default;
+
+    std::uint8_t *table_ = nullptr;
+    const std::uint16_t *move_a_ = nullptr;
+    const std::uint16_t *move_b_ = nullptr;
+    int size_b_ = 0;
+    int size_ = 0;
+    const int *moves_ = nullptr;
+    int nmoves_ = 0;
+    int depth_ = 0;
+    std::atomic<int> next_chunk_{0};
+    std::atomic<int> found_{0};
+    int generation_ = 0;
+    int working_ = 0;
+    bool unblocked_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    /*
+    called by master thread.
+    */
+    void post(
+        int depth,
+        int nworkers
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            depth_ = depth;
+            next_chunk_ = 0;
+            found_ = 0;
+            working_ = nworkers;
+            ++generation_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by worker threads.
+    waits for a new pass.
+    returns false when unblocked.
+    */
+    bool wait(
+        int &generation
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (generation_ == generation && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (unblocked_) {
+            return false;
+        }
+        generation = generation_;
+        return true;
+    }
+
+    /*
+    called by all threads.
+    */
+    void runChunks() noexcept {
+        auto table = table_;
+        int depth = depth_;
+        int size_b = size_b_;
+        for(;;) {
+            int begin = next_chunk_.fetch_add(1) * kChunkEntries;
+            if (begin >= size_) {
+                break;
+            }
+            int end = std::min(begin + kChunkEntries, size_);
+            int found = 0;
+            for (int i = begin; i < end; ++i) {
+                if (getEntry(table, i) != depth) {
+                    continue;
+                }
+                int a = i / size_b;
+                int b = i % size_b;
+                for (int k = 0; k < nmoves_; ++k) {
+                    int m = moves_[k];
+                    int j = move_a_[a * kNumMoves + m] * size_b + move_b_[b * kNumMoves + m];
+                    if (setIfUnknown(table, j, depth + 1)) {
+                        ++found;
+                    }
+                }
+            }
+            found_ += found;
+        }
+    }
+
+    /*
+    called by worker threads.
+    */
+    void done() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            --working_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by master thread.
+    */
+    void waitDone() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (working_ > 0 && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+        }
+        cv_.notify_all();
+    }
+};
+
+namespace {
+    class PruneWorker : public agm::Thread {
+    public:
+        PruneWorker(
+            PruneBuild *build
+        ) noexcept :
+            agm::Thread("PruneWorker"),
+            build_(build) {
+        }
+
+        virtual ~PruneWorker() = default;
+
+        PruneBuild *build_;
+        int generation_ = 0;
+
+        virtual void runOnce() noexcept {
+            auto good = build_->wait(generation_);
+            if (good == false) {
+                return;
+            }
+            build_->runChunks();
+            build_->done();
+        }
+    };
+
+    int buildTable(
+        PruneBuild *build,
+        int nworkers,
+        std::uint8_t *table,
+        int size,
+        const std::vector<std::uint16_t>& move_a,
+        const std::vector<std::uint16_t>& move_b,
+        int size_b,
+        const int *moves,
+        int nmoves
+    ) noexcept {
+        std::memset(table, 0xFF, (size + 1) / 2);
+        table[0] = 0xF0;
+        build->table_ = table;
+        build->move_a_ = move_a.data();
+        build->move_b_ = move_b.data();
+        build->size_b_ = size_b;
+        build->size_ = size;
+        build->moves_ = moves;
+        build->nmoves_ = nmoves;
+
+        int depth = 0;
+        for(;;) {
+            build->post(depth, nworkers);
+            build->runChunks();
+            build->waitDone();
+            if (build->found_ == 0) {
+                break;
+            }
+            ++depth;
+        }
+        return depth;
+    }
+}
+
+PruneTables::PruneTables() noexcept {
+}
+
+PruneTables::~PruneTables() noexcept {
+    exit();
+}
+
+void PruneTables::init(
+    const MoveTables& moves
+) noexcept {
+    exit();
+    auto start = std::chrono::steady_clock::now();
+
+    data_.resize(dataBytes());
+    auto data = data_.data();
+    std::uint8_t *tables[kNumTables];
+    for (int i = 0; i < kNumTables; ++i) {
+        tables[i] = data;
+        data += tableBytes(g_table_entries[i]);
+    }
+
+    // the master thread is a worker too.
+    int nworkers = int(std::thread::hardware_concurrency()) - 1;
+    nworkers = std::max(0, std::min(nworkers, kMaxWorkers));
+    std::vector<agm::Thread *> threads;
+    std::vector<agm::Container *> containers;
+    auto build = new(std::nothrow) PruneBuild;
+    containers.push_back(build);
+    for (int i = 0; i < nworkers; ++i) {
+        threads.push_back(new(std::nothrow) PruneWorker(build));
+    }
+    agm::Thread::startAll(threads, containers);
+
+    int all_moves[kNumMoves];
+    for (int i = 0; i < kNumMoves; ++i) {
+        all_moves[i] = i;
+    }
+    int depth[kNumTables];
+    depth[0] = buildTable(build, nworkers, tables[0], g_table_entries[0],
+        moves.twist_, moves.slice_, kNumSlice, all_moves, kNumMoves);
+    depth[1] = buildTable(build, nworkers, tables[1], g_table_entries[1],
+        moves.flip_, moves.slice_, kNumSlice, all_moves, kNumMoves);
+    depth[2] = buildTable(build, nworkers, tables[2], g_table_entries[2],
+        moves.corner_perm_, moves.slice_perm_, kNumSlicePerm, g_phase2_moves, kNumPhase2Moves);
+    depth[3] = buildTable(build, nworkers, tables[3], g_table_entries[3],
+        moves.edge_perm_, moves.slice_perm_, kNumSlicePerm, g_phase2_moves, kNumPhase2Moves);
+
+    // deletes the build.
+    agm::Thread::stopAll(threads, containers);
+
+    setPointers(data_.data());
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    LOG("built pruning tables workers=" << nworkers << " ms=" << ms
+        << " depths=" << depth[0] << " " << depth[1] << " " << depth[2] << " " << depth[3]);
+}
+
+bool PruneTables::load(
+    const char *filename
+) noexcept {
+    exit();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        LOG("No pruning tables: " << filename);
+        return false;
+    }
+    struct stat info;
+    int result = fstat(fd, &info);
+    std::size_t length = info.st_size;
+    if (result < 0 || length != sizeof(Header) + dataBytes()) {
+        LOG("Wrong size pruning tables: " << filename);
+        close(fd);
+        return false;
+    }
+    auto map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    // the map keeps the file open.
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOG("Failed to map pruning tables: " << filename);
+        return false;
+    }
+
+    auto header = (const Header *) map;
+    bool good = (std::memcmp(header->magic_, kMagic, sizeof(kMagic)) == 0)
+        && (header->version_ == kVersion)
+        && (header->num_tables_ == kNumTables);
+    for (int i = 0; good && i < kNumTables; ++i) {
+        good = (header->entries_[i] == std::uint32_t(g_table_entries[i]));
+    }
+    if (good == false) {
+        LOG("Wrong version pruning tables: " << filename);
+        munmap(map, length);
+        return false;
+    }
+
+    map_ = map;
+    map_length_ = length;
+    setPointers((const std::uint8_t *) map + sizeof(Header));
+    LOG("mapped pruning tables: " << filename << " bytes=" << length);
+    return true;
+}
+
+/*
+write to a temporary file and rename it.
+so no process ever maps a partial file.
+*/
+bool PruneTables::save(
+    const char *filename
+) noexcept {
+    if (data_.empty()) {
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, kMagic, sizeof(kMagic));
+    header.version_ = kVersion;
+    header.num_tables_ = kNumTables;
+    for (int i = 0; i < kNumTables; ++i) {
+        header.entries_[i] = g_table_entries[i];
+    }
+
+    std::string temp = filename;
+    temp += ".tmp";
+    auto fp = std::fopen(temp.c_str(), "wb");
+    if (fp == nullptr) {
+        LOG("Failed to create: " << temp);
+        return false;
+    }
+    auto n = std::fwrite(&header, sizeof(header), 1, fp);
+    n += std::fwrite(data_.data(), data_.size(), 1, fp);
+    auto result = std::fclose(fp);
+    if (n != 2 || result != 0) {
+        LOG("Failed to write: " << temp);
+        std::remove(temp.c_str());
+        return false;
+    }
+    result = std::rename(temp.c_str(), filename);
+    if (result != 0) {
+        LOG("Failed to rename: " << temp);
+        std::remove(temp.c_str());
+        return false;
+    }
+    LOG("saved pruning tables: " << filename << " bytes=" << sizeof(header) + data_.size());
+    return true;
+}
+
+void PruneTables::exit() noexcept {
+    if (map_) {
+        munmap(map_, map_length_);
+        map_ = nullptr;
+        map_length_ = 0;
+    }
+    data_.clear();
+    data_.shrink_to_fit();
+    twist_slice_ = nullptr;
+    flip_slice_ = nullptr;
+    corner_slice_ = nullptr;
+    edge_slice_ = nullptr;
+}
+
+void PruneTables::setPointers(
+    const std::uint8_t *data
+) noexcept {
+    twist_slice_ = data;
+    data += tableBytes(g_table_entries[0]);
+    flip_slice_ = data;
+    data += tableBytes(g_table_entries[1]);
+    corner_slice_ = data;
+    data += tableBytes(g_table_entries[2]);
+    edge_slice_ = data;
+}
@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+pruning tables for the two phase solver.
+
+each entry is the exact number of moves to solve
+a pair of coordinates ignoring everything else.
+so it's a lower bound for the whole cube.
+which makes the search admissible.
+
+phase 1 solves twist flip and slice.
+the tables are twist x slice and flip x slice.
+phase 2 solves the rest using only phase 2 moves.
+the tables are corner perm x slice perm and edge perm x slice perm.
+
+the entries are 4 bits. two per byte. about 2 MB.
+
+built by breadth first search from the solved cube.
+one pass per depth.
+each pass is split among a pool of worker threads.
+
+building takes a while.
+so the tables are saved to a file ahead of time.
+rubiks --gen-tables
+the file is mapped read only.
+so every process on the machine shares the same pages.
+the file has a version.
+a file from an older version is ignored.
+**/
+
+#include "coord.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class PruneTables {
+public:
+    PruneTables() noexcept;
+    PruneTables(const PruneTables &) = delete;
+    ~PruneTables() noexcept;
+
+    // build the tables in memory.
+    void init(const MoveTables& moves) noexcept;
+
+    // map the tables from the file.
+    // returns false if the file is missing or the wrong version.
+    bool load(const char *filename) noexcept;
+
+    // write the tables built by init.
+    bool save(const char *filename) noexcept;
+
+    // unmap or free the tables.
+    void exit() noexcept;
+
+    int phase1(int twist, int flip, int slice) const noexcept {
+        int a = get(twist_slice_, twist * kNumSlice + slice);
+        int b = get(flip_slice_, flip * kNumSlice + slice);
+        return (a > b) ? a : b;
+    }
+
+    int phase2(int corners, int edges, int slice_perm) const noexcept {
+        int a = get(corner_slice_, corners * kNumSlicePerm + slice_perm);
+        int b = get(edge_slice_, edges * kNumSlicePerm + slice_perm);
+        return (a > b) ? a : b;
+    }
+
+private:
+    const std::uint8_t *twist_slice_ = nullptr;
+    const std::uint8_t *flip_slice_ = nullptr;
+    const std::uint8_t *corner_slice_ = nullptr;
+    const std::uint8_t *edge_slice_ = nullptr;
+
+    // built by init.
+    std::vector<std::uint8_t> data_;
+    // or mapped by load.
+    void *map_ = nullptr;
+    std::size_t map_length_ = 0;
+
+    static int get(const std::uint8_t *table, int index) noexcept {
+        return (table[index >> 1] >> ((index & 1) * 4)) & 0xF;
+    }
+
+    void setPointers(const std::uint8_t *data) noexcept;
+};
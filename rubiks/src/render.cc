@@ -8,14 +8,24 @@ spinning rubik's cube.
 the rubik's cube is a 3x3x3 stack of identical colored cubes.
 we don't render the center cube.
 cause it can never be seen.
+
+every cube is the same mesh.
+the bevel and the stickers are one list of triangles.
+each vertex has its own color.
+the cubes are instances of the mesh.
+each instance has its own model matrix.
+so the whole cube is one draw call.
 **/
 
+#include "cube.h"
 #include "render.h"
+#include "solver.h"
 
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 #include <aggiornamento/opengl.h>
-#include <common/png.h>
+#include <common/capture.h>
+#include <common/stats.h>
 
 #include <GLES3/gl3.h>
 
@@ -25,9 +35,8 @@ cause it can never be seen.
 #include <glm/gtc/matrix_transform.hpp>
 //#include <glm/gtx/quaternion.hpp>
 
-#include <iomanip>
 #include <random>
-#include <sstream>
+#include <vector>
 
 #if !defined(XK_MISCELLANY)
 #define XK_MISCELLANY 1
@@ -39,18 +48,21 @@ namespace {
     auto g_vertex_source =R"shader_code(
         #version 310 es
         layout (location = 0) in vec3 vertex_pos_in;
-        uniform mat4 model_mat;
+        layout (location = 1) in vec3 vertex_color_in;
+        layout (location = 2) in mat4 model_mat;
         uniform mat4 proj_view_mat;
+        out vec3 color;
         void main() {
             vec4 world_pos = model_mat * vec4(vertex_pos_in, 1.0f);
             gl_Position = proj_view_mat * world_pos;
+            color = vertex_color_in;
         }
     )shader_code";
 
     auto g_fragment_source = R"shader_code(
         #version 310 es
+        in mediump vec3 color;
         out mediump vec4 color_out;
-        uniform mediump vec3 color;
         void main() {
 			color_out.rgb = color;
             color_out.a = 1.0f;
@@ -61,10 +73,6 @@ namespace {
 	const float kSecondsPerRotation = 0.5f;
 	const int kFramesPerRotation = (int)( kFramesPerSecond * kSecondsPerRotation );
 
-	const int kNumFaceCubes = 9;
-	const int kNumCubes = 26;
-	const int kNumStates = 24;
-
     const GLfloat kA = 0.50f;  /// sub-cube size
     const GLfloat kB = 0.45f;  /// sticker size
     const GLfloat kC = 0.48f;  /// bevel
@@ -131,6 +139,7 @@ namespace {
 		1.0f, 1.0f, 1.0f, /// white
 		0.9f, 0.9f, 0.0f, /// yellow
 	};
+	const GLfloat g_bevel_color[] = {0.1f, 0.1f, 0.1f};
 	const GLushort g_bevel_indexes[] = {
 		8*0+0, 8*0+1, 8*0+2,
 		8*0+0, 8*0+2, 8*0+4,
@@ -294,166 +303,13 @@ namespace {
 		g_rotzm, g_rotxp*g_rotzm, g_rotx2*g_rotzm, g_rotxm*g_rotzm
 	};
 
-	const int g_mapxp[kNumCubes] = {
-		2,  5,  8,  1,  4,  7,  0,  3,  6,
-		11, 13, 16, 10,     15, 9,  12, 14,
-		19, 22, 25, 18, 21, 24, 17, 20, 23
-	};
-	const int g_mapxm[kNumCubes] = {
-		6,  3,  0,  7,  4,  1,  8,  5,  2,
-		14, 12, 9,  15,     10, 16, 13, 11,
-		23, 20, 17, 24, 21, 18, 25, 22, 19
-	};
-	const int g_mapyp[kNumCubes] = {
-		17, 9,  0,  20, 12, 3,  23, 14, 6,
-		18, 10, 1,  21,     4,  24, 15, 7,
-		19, 11, 2,  22, 13, 5,  25, 16, 8
-	};
-	const int g_mapym[kNumCubes] = {
-		2,  11, 19, 5,  13, 22, 8,  16, 25,
-		1,  10, 18, 4,      21, 7,  15, 24,
-		0,  9,  17, 3,  12, 20, 6,  14, 23
-	};
-	const int g_mapzp[kNumCubes] = {
-		6,  7,  8, 14, 15, 16, 23, 24, 25,
-		3,  4,  5, 12,     13, 20, 21, 22,
-		0,  1,  2, 9,  10, 11, 17, 18, 19
-	};
-	const int g_mapzm[kNumCubes] = {
-		17, 18, 19, 9,  10, 11, 0,  1,  2,
-		20, 21, 22, 12,     13, 3,  4,  5,
-		23, 24, 25, 14, 15, 16, 6,  7,  8
-	};
-	const int g_state_xp[kNumStates] = {
-		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, 17, 18, 19, 16, 21, 22, 23, 20
-	};
-	const int g_state_xm[kNumStates] = {
-		3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 19, 16, 17, 18, 23, 20, 21, 22
-	};
-	const int g_state_yp[kNumStates] = {
-		4, 21, 14, 19, 8, 22, 2, 18, 12, 23, 6, 17, 0, 20, 10, 16, 5, 1, 13, 9, 7, 11, 15, 3
-	};
-	const int g_state_ym[kNumStates] = {
-		12, 17, 6, 23, 0, 16, 10, 20, 4, 19, 14, 21, 8, 18, 2, 22, 15, 11, 7, 3, 13, 1, 5, 9
-	};
-	const int g_state_zp[kNumStates] = {
-		16, 5, 22, 15, 19, 9, 23, 3, 18, 13, 20, 7, 17, 1, 21, 11, 10, 6, 2, 14, 0, 4, 8, 12
-	};
-	const int g_state_zm[kNumStates] = {
-		20, 13, 18, 7, 21, 1, 17, 11, 22, 5, 16, 15, 23, 9, 19, 3, 0, 12, 8, 4, 10, 14, 2, 6
-	};
-
-	class StateChange {
-	public:
-		int symbol_;
-		const char *text_;
-		const int *rotation_map_;
-		const int *state_map_;
-		glm::vec3 axis_;
-		int count_;
-	};
-
-	const int kUp = XK_Up;
-	const int kDn = XK_Down;
-
-	const StateChange g_change_a  = {'a', "A",  g_mapym, g_state_ym, {+0.0f, -1.0f, +0.0f}, kNumCubes};
-	const StateChange g_change_d  = {'d', "D",  g_mapyp, g_state_yp, {+0.0f, +1.0f, +0.0f}, kNumCubes};
-	const StateChange g_change_s  = {'s', "S",  g_mapzm, g_state_zm, {+0.0f, +0.0f, -1.0f}, kNumCubes};
-	const StateChange g_change_w  = {'w', "W",  g_mapzp, g_state_zp, {+0.0f, +0.0f, +1.0f}, kNumCubes};
-	const StateChange g_change_up = {kUp, "Up", g_mapxm, g_state_xm, {-1.0f, +0.0f, +0.0f}, kNumFaceCubes};
-	const StateChange g_change_dn = {kDn, "Dn", g_mapxp, g_state_xp, {+1.0f, +0.0f, +0.0f}, kNumFaceCubes};
-	const StateChange g_change_na = {0,   "",   nullptr, nullptr,    {+0.0f, +0.0f, +0.0f}, 0};
-
-	const StateChange g_change_table[] = {
-		g_change_a, g_change_d, g_change_s, g_change_w, g_change_up, g_change_dn
-	};
-
-	class MixUp {
-	public:
-		float prob_;
-		const StateChange *change_;
-		const MixUp *next_;
-	};
-	extern const MixUp g_mixup_all[];
-	extern const MixUp g_mixup_up2[];
-	extern const MixUp g_mixup_a2[];
-	extern const MixUp g_mixup_w2[];
-	extern const MixUp g_mixup_ad_sw[];
-	extern const MixUp g_mixup_ad_updn[];
-	extern const MixUp g_mixup_sw_updn[];
-	const MixUp g_mixup_all[] = {
-		{1.0f/9.0f, &g_change_up, g_mixup_ad_sw},
-		{1.0f/9.0f, &g_change_dn, g_mixup_ad_sw},
-		{1.0f/9.0f, &g_change_up, g_mixup_up2},
-		{1.0f/9.0f, &g_change_a,  g_mixup_sw_updn},
-		{1.0f/9.0f, &g_change_d,  g_mixup_sw_updn},
-		{1.0f/9.0f, &g_change_a,  g_mixup_a2},
-		{1.0f/9.0f, &g_change_w,  g_mixup_ad_updn},
-		{1.0f/9.0f, &g_change_s,  g_mixup_ad_updn},
-		{2.0f,      &g_change_w,  g_mixup_w2},
-	};
-	const MixUp g_mixup_up2[] = {
-		{2.0f,      &g_change_up, g_mixup_ad_sw},
-	};
-	const MixUp g_mixup_a2[] = {
-		{2.0f,      &g_change_a,  g_mixup_sw_updn},
-	};
-	const MixUp g_mixup_w2[] = {
-		{2.0f,      &g_change_w,  g_mixup_ad_updn},
-	};
-	const MixUp g_mixup_ad_sw[] = {
-		{1.0f/6.0f, &g_change_a,  g_mixup_sw_updn},
-		{1.0f/6.0f, &g_change_d,  g_mixup_sw_updn},
-		{1.0f/6.0f, &g_change_a,  g_mixup_a2},
-		{1.0f/6.0f, &g_change_w,  g_mixup_ad_updn},
-		{1.0f/6.0f, &g_change_s,  g_mixup_ad_updn},
-		{2.0f,      &g_change_w,  g_mixup_w2},
-	};
-	const MixUp g_mixup_ad_updn[] = {
-		{1.0f/6.0f, &g_change_up, g_mixup_ad_sw},
-		{1.0f/6.0f, &g_change_dn, g_mixup_ad_sw},
-		{1.0f/6.0f, &g_change_up, g_mixup_up2},
-		{1.0f/6.0f, &g_change_a,  g_mixup_sw_updn},
-		{1.0f/6.0f, &g_change_d,  g_mixup_sw_updn},
-		{2.0f,      &g_change_a,  g_mixup_a2},
-	};
-	const MixUp g_mixup_sw_updn[] = {
-		{1.0f/6.0f, &g_change_up, g_mixup_ad_sw},
-		{1.0f/6.0f, &g_change_dn, g_mixup_ad_sw},
-		{1.0f/6.0f, &g_change_up, g_mixup_up2},
-		{1.0f/6.0f, &g_change_w,  g_mixup_ad_updn},
-		{1.0f/6.0f, &g_change_s,  g_mixup_ad_updn},
-		{2.0f,      &g_change_w,  g_mixup_w2},
-	};
-
-	class PieceState {
-	public:
-		int index_;
-		int orient_;
-	};
-
-	class CubeState {
-	public:
-		PieceState pieces_[kNumCubes];
-	};
-
-	class SearchState {
-	public:
-		const StateChange *change_;
-		CubeState state_;
-	};
-
     class RenderImpl : public Render {
     public:
         RenderImpl() noexcept :
 			ran_eng_(ran_dev_()),
 			ran_turn_(0.0f, 1.0f) {
 
-			for (int i = 0; i < kNumCubes; ++i) {
-				auto& s = state_.pieces_[i];
-				s.index_ = i;
-				s.orient_ = 0;
-			}
+			state_.reset();
 			/*state_.pieces_[3].orient_ = 7;
 			state_.pieces_[5].orient_ = 7;
 			state_.pieces_[20].orient_ = 7;
@@ -465,17 +321,16 @@ namespace {
         int width_ = 0;
         int height_ = 0;
         GLuint vertex_buffer_ = 0;
-        GLuint bevel_index_buffer_ = 0;
-        GLuint face_index_buffer_[6] = {0};
+        GLuint instance_buffer_ = 0;
         GLuint vertex_shader_ = 0;
         GLuint fragment_shader_ = 0;
         GLuint program_ = 0;
-        GLuint model_mat_loc_ = 0;
         GLuint proj_view_mat_loc_ = 0;
-        GLuint color_loc_ = 0;
-        int num_bevel_indexes_ = 0;
-        int num_face_indexes_ = 0;
-        int frame_count_ = 0;
+        int num_vertexes_ = 0;
+        glm::mat4 model_mats_[kNumCubes];
+        FrameCapture capture_{"output/rubiks", 48*60};
+        bool capture_on_ = false;
+        FrameStats stats_;
 		CubeState state_;
 		int rotate_counter_ = 0;
 		const StateChange *state_change_ = nullptr;
@@ -484,9 +339,28 @@ namespace {
 		std::random_device ran_dev_;
 		std::default_random_engine ran_eng_;
 		std::uniform_real_distribution<> ran_turn_;
-		int correctness_ = 0;
-		std::vector<SearchState> moves_;
-		int best_score_ = 0;
+		std::vector<const StateChange *> moves_;
+		Solver solver_;
+		const char *tables_ = nullptr;
+
+        virtual void setCapture(
+            const char *name
+        ) noexcept {
+            capture_.setOutput(name);
+            capture_on_ = true;
+        }
+
+        virtual void setStats(
+            bool overlay
+        ) noexcept {
+            stats_.enable(overlay);
+        }
+
+        virtual void setTables(
+            const char *filename
+        ) noexcept {
+            tables_ = filename;
+        }
 
         virtual void init(
             int width,
@@ -497,31 +371,24 @@ namespace {
 
             //genTables();
 
-            int num_vertex_floats = 3 * 8 * 6;
-            num_bevel_indexes_ = 3 * 8 * 6;
-            num_face_indexes_ = 3 * 2;
-
             glEnable(GL_DEPTH_TEST);
             glDepthFunc(GL_LESS);
             glEnable(GL_CULL_FACE);
 
+            std::vector<GLfloat> vertexes;
+            buildMesh(vertexes);
+            num_vertexes_ = vertexes.size() / 6;
             glGenBuffers(1, &vertex_buffer_);
             glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*num_vertex_floats, g_cube_vertexes, GL_STATIC_DRAW);
-            LOG("GL vertex=" << vertex_buffer_);
-
-            glGenBuffers(1, &bevel_index_buffer_);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bevel_index_buffer_);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*num_bevel_indexes_, g_bevel_indexes, GL_STATIC_DRAW);
-            LOG("GL bevel_index=" << bevel_index_buffer_);
-
-            glGenBuffers(6, &face_index_buffer_[0]);
-            for (int i = 0; i < 6; ++i) {
-				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, face_index_buffer_[i]);
-				auto face_indexes = &g_face_indexes[num_face_indexes_*i];
-				glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*num_face_indexes_, face_indexes, GL_STATIC_DRAW);
-				LOG("GL face_index[" << i << "]=" << face_index_buffer_[i]);
-			}
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*vertexes.size(), vertexes.data(), GL_STATIC_DRAW);
+            LOG("GL vertex=" << vertex_buffer_ << " vertexes=" << num_vertexes_);
+
+            /// the model matrices change every frame.
+            glGenBuffers(1, &instance_buffer_);
+            glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(model_mats_), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            LOG("GL instance=" << instance_buffer_);
 
             vertex_shader_ = agm::gl::compileShader(GL_VERTEX_SHADER, g_vertex_source);
             LOG("GL vertex_shader=" << vertex_shader_);
@@ -532,15 +399,16 @@ namespace {
             LOG("GL program=" << program_);
 
             glUseProgram(program_);
-            model_mat_loc_ = glGetUniformLocation(program_, "model_mat");
-            LOG("GL model_mat_loc=" << model_mat_loc_);
             proj_view_mat_loc_ = glGetUniformLocation(program_, "proj_view_mat");
             LOG("GL proj_view_mat_loc=" << proj_view_mat_loc_);
-            color_loc_ = glGetUniformLocation(program_, "color");
-            LOG("GL color_loc=" << color_loc_);
+
+            solver_.init(tables_);
         }
 
         virtual void exit() noexcept {
+            solver_.exit();
+            stats_.exit();
+            capture_.exit();
             if (program_) {
                 if (fragment_shader_) {
                     glDetachShader(program_, fragment_shader_);
@@ -559,16 +427,10 @@ namespace {
                 glDeleteShader(vertex_shader_);
                 vertex_shader_ = 0;
             }
-            if (bevel_index_buffer_) {
-                glDeleteBuffers(1, &bevel_index_buffer_);
-                bevel_index_buffer_ = 0;
+            if (instance_buffer_) {
+                glDeleteBuffers(1, &instance_buffer_);
+                instance_buffer_ = 0;
             }
-            for (int i = 0; i < 6; ++i) {
-				if (face_index_buffer_[i]) {
-					glDeleteBuffers(1, &face_index_buffer_[i]);
-					face_index_buffer_[i] = 0;
-				}
-			}
             if (vertex_buffer_) {
                 glDeleteBuffers(1, &vertex_buffer_);
                 vertex_buffer_ = 0;
@@ -576,7 +438,10 @@ namespace {
         }
 
         virtual void draw() noexcept {
+            stats_.beginFrame();
+            stats_.stage("update");
 			int rotate = updateDraw();
+            stats_.stage("draw");
 
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -588,7 +453,7 @@ namespace {
 				rot_mat = std::move(glm::rotate(
 					glm::mat4(),
 					angle,
-					state_change_->axis_
+					glm::vec3(state_change_->axis_[0], state_change_->axis_[1], state_change_->axis_[2])
 				));
 			}
 
@@ -609,18 +474,16 @@ namespace {
 
             glUseProgram(program_);
             glUniformMatrix4fv(proj_view_mat_loc_, 1, GL_FALSE, &proj_view_mat[0][0]);
-            glEnableVertexAttribArray(0);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
 			drawAllCubes(rot_mat);
 
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glDisableVertexAttribArray(0);
             glUseProgram(0);
 
-			//captureFrame();
+            stats_.stage("capture");
+            if (capture_on_) {
+                captureFrame();
+            }
+            stats_.endFrame(width_, height_);
         }
 
         void drawAllCubes(
@@ -630,11 +493,41 @@ namespace {
 			if (state_change_) {
 				ncubes = state_change_->count_;
 			}
-			drawSomeCubes(rot_mat, 0, ncubes);
-			drawSomeCubes(g_ident, ncubes, kNumCubes);
+			setModelMats(rot_mat, 0, ncubes);
+			setModelMats(g_ident, ncubes, kNumCubes);
+
+			/// position and color.
+			GLsizei stride = sizeof(GLfloat) * 6;
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (const void *) (sizeof(GLfloat) * 3));
+
+			/// a mat4 is 4 vec4 attributes.
+			glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(model_mats_), &model_mats_[0][0][0]);
+			for (int i = 0; i < 4; ++i) {
+				GLuint loc = 2 + i;
+				glEnableVertexAttribArray(loc);
+				glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const void *) (sizeof(glm::vec4) * i));
+				glVertexAttribDivisor(loc, 1);
+			}
+
+			glDrawArraysInstanced(GL_TRIANGLES, 0, num_vertexes_, kNumCubes);
+			stats_.countDraw(num_vertexes_ / 3 * kNumCubes);
+
+			for (int i = 0; i < 4; ++i) {
+				GLuint loc = 2 + i;
+				glVertexAttribDivisor(loc, 0);
+				glDisableVertexAttribArray(loc);
+			}
+			glDisableVertexAttribArray(1);
+			glDisableVertexAttribArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 
-		void drawSomeCubes(
+		void setModelMats(
 			const glm::mat4& rot_mat,
 			int start,
 			int stop
@@ -645,24 +538,32 @@ namespace {
 					rot_mat,
 					g_xyz[i]
 				);
-				glm::mat4 model_mat = temp_mat * g_rot_table[s.orient_];
-				glUniformMatrix4fv(model_mat_loc_, 1, GL_FALSE, &model_mat[0][0]);
-				draw1Cube();
+				model_mats_[i] = temp_mat * g_rot_table[s.orient_];
 			}
         }
 
-        void draw1Cube() noexcept {
-			GLfloat dark[] = {0.1f, 0.1f, 0.1f};
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bevel_index_buffer_);
-			glUniform3fv(color_loc_, 1, &dark[0]);
-			glDrawElements(GL_TRIANGLES, num_bevel_indexes_, GL_UNSIGNED_SHORT, nullptr);
-
+		/*
+		unroll the indexed bevel and stickers into one triangle list.
+		the bevel and the stickers share vertexes.
+		but not colors.
+		*/
+		void buildMesh(
+			std::vector<GLfloat>& vertexes
+		) noexcept {
+			auto add = [&](const GLushort *indexes, int count, const GLfloat *color) {
+				for (int i = 0; i < count; ++i) {
+					auto pos = &g_cube_vertexes[3*indexes[i]];
+					vertexes.insert(vertexes.end(), pos, pos + 3);
+					vertexes.insert(vertexes.end(), color, color + 3);
+				}
+			};
+			int num_bevel_indexes = sizeof(g_bevel_indexes) / sizeof(g_bevel_indexes[0]);
+			add(g_bevel_indexes, num_bevel_indexes, g_bevel_color);
+			int num_face_indexes = 3 * 2;
 			for (int i = 0; i < 6; ++i) {
-				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, face_index_buffer_[i]);
-				glUniform3fv(color_loc_, 1, &g_colors[3*i]);
-				glDrawElements(GL_TRIANGLES, num_face_indexes_, GL_UNSIGNED_SHORT, nullptr);
+				add(&g_face_indexes[num_face_indexes*i], num_face_indexes, &g_colors[3*i]);
 			}
-        }
+		}
 
         virtual void resize(
             int width,
@@ -673,71 +574,50 @@ namespace {
         }
 
         void captureFrame() noexcept {
-            if (frame_count_ >= 48*60) {
-                return;
-            }
-
-            Png png_flipped;
-            png_flipped.init(width_, height_);
-            glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, png_flipped.data_);
-            //png_flipped.write("flipped.png");
-
-            Png png;
-            png.init(width_, height_);
-            auto src = png_flipped.data_ + (height_ - 1)*png_flipped.stride_;
-            auto dst = png.data_;
-            for (int i = 0; i < height_; ++i) {
-                std::memcpy(dst, src, png.stride_);
-                src -= png_flipped.stride_;
-                dst += png.stride_;
-            }
-
-            std::stringstream ss;
-            ss << "output/rubiks" << std::setfill('0') << std::setw(5) << frame_count_
-                << std::setfill(' ') << std::setw(0) << ".png";
-            LOG("ss=" << ss.str().c_str());
-            png.write(ss.str().c_str());
-
-            ++frame_count_;
+            capture_.capture(width_, height_);
         }
 
 		virtual void keyPressed(
 			int symbol
 		) noexcept {
+			/// any key abandons the solution.
+			solver_.cancel();
+			moves_.clear();
+
 			symbol = tolower(symbol);
 			if (symbol == ' ') {
 				mix_up_ = mix_up_ ? nullptr : g_mixup_all;
 			} else if (symbol == XK_Home) {
 				mix_up_ = nullptr;
-				searchSolution();
+				/// the turn in progress is already in the state.
+				solver_.solve(state_);
 			} else {
-				for (auto change = g_change_table; change->symbol_; ++change) {
-					if (symbol == change->symbol_) {
-						key_queue_ = change;
-						break;
-					}
+				queueChange(symbol);
+			}
+		}
+
+		void queueChange(
+			int symbol
+		) noexcept {
+			for (auto change = g_change_table; change->symbol_; ++change) {
+				if (symbol == change->symbol_) {
+					key_queue_ = change;
+					break;
 				}
 			}
 		}
 
 		int updateDraw() noexcept {
+			solver_.poll(moves_);
 			if (rotate_counter_ < 0) {
 				if (key_queue_ == nullptr) {
 					if (mix_up_) {
-						float ran_idx = ran_turn_(ran_eng_);
-						for (auto dist = mix_up_; ; ++dist) {
-							if (ran_idx < dist->prob_) {
-								auto change = dist->change_;
-								keyPressed(change->symbol_);
-								mix_up_ = dist->next_;
-								break;
-							}
-							ran_idx -= dist->prob_;
-						}
+						auto change = mixUp(mix_up_, ran_turn_(ran_eng_));
+						queueChange(change->symbol_);
 					} else {
 						if (moves_.size()) {
 							auto head = moves_.begin();
-							key_queue_ = head->change_;
+							key_queue_ = *head;
 							moves_.erase(head);
 						}
 					}
@@ -747,7 +627,6 @@ namespace {
 					state_change_ = key_queue_;
 					key_queue_ = nullptr;
 					changeState(state_change_, state_, state_);
-					correctness_ = checkCorrectness(state_);
 				}
 			}
 			int rotate = std::max(0, rotate_counter_);
@@ -755,88 +634,6 @@ namespace {
 			return rotate;
 		}
 
-		void changeState(
-			const StateChange *change,
-			const CubeState& old_state,
-			CubeState& new_state
-		) noexcept {
-			CubeState temp_state = old_state;
-			int ncubes = change->count_;
-			for (int i = 0; i < ncubes; ++i) {
-				int new_idx = change->rotation_map_[i];
-				auto& s = old_state.pieces_[new_idx];
-				int moved_idx = s.orient_;
-				int rot_idx = change->state_map_[moved_idx];
-				auto& ns = temp_state.pieces_[i];
-				ns.index_ = s.index_;
-				ns.orient_ = rot_idx;
-			}
-			new_state = temp_state;
-		}
-
-		int checkCorrectness(
-			const CubeState& state
-		) noexcept {
-			int new_correctness = 0;
-			best_score_ = 0;
-			if (new_correctness == best_score_) {
-				best_score_ += 1;
-				/// check if white center (10) is on the top face.
-				/// we don't care about orientation.
-				if (state.pieces_[10].index_ == 10) {
-					new_correctness += 1;
-				}
-			}
-			if (new_correctness == best_score_) {
-				best_score_ += 4;
-				/// check if the top edge pieces (1 9 11 18) are in the correct place
-				/// and oriented correctly.
-				int check_list[] = {1, 9, 11, 18};
-				for (int i = 0; i < intsizeof(check_list)/intsizeof(int); ++i) {
-					int idx = check_list[i];
-					auto& s = state.pieces_[idx];
-					if (s.index_ == idx && s.orient_ == 0) {
-						++new_correctness;
-					}
-				}
-			}
-			if (new_correctness == best_score_) {
-				best_score_ += 1;
-				/// check if blue center (4) is on the right face.
-				/// we don't care about orientation.
-				if (state.pieces_[4].index_ == 4 && state.pieces_[10].index_ == 10) {
-					new_correctness += 1;
-				}
-			}
-			if (new_correctness == best_score_) {
-				best_score_ += 4;
-				/// check if the top corner pieces (0 2 17 19) are in the correct place
-				/// and oriented correctly.
-				int check_list[] = {0, 2, 17, 19};
-				for (int i = 0; i < intsizeof(check_list)/intsizeof(int); ++i) {
-					int idx = check_list[i];
-					auto& s = state.pieces_[idx];
-					if (s.index_ == idx && s.orient_ == 0) {
-						++new_correctness;
-					}
-				}
-			}
-			if (new_correctness == best_score_) {
-				best_score_ += 4;
-				/// check if the middle edge pieces (3 5 20 22) are in the correct place
-				/// and oriented correctly.
-				int check_list[] = {3, 5, 20, 22};
-				for (int i = 0; i < intsizeof(check_list)/intsizeof(int); ++i) {
-					int idx = check_list[i];
-					auto& s = state.pieces_[idx];
-					if (s.index_ == idx && s.orient_ == 0) {
-						++new_correctness;
-					}
-				}
-			}
-			return new_correctness;
-		}
-
 		void genTables() noexcept {
 			genTable(g_rotxp);
 			genTable(g_rotxm);
@@ -883,89 +680,6 @@ namespace {
 			std::cout << std::endl;
 		}
 
-		void searchSolution() noexcept {
-			if (correctness_ == best_score_) {
-				LOG("It's solved!");
-				return;
-			}
-
-			LOG("starting correctness=" << correctness_);
-			//logState(state_);
-			bool found = false;
-			int correctness = 0;
-			const int kSearchDepth = 20;
-			int depth = 1;
-			for (; depth <= kSearchDepth; ++depth) {
-				LOG("searching depth: " << depth);
-				moves_.clear();
-				SearchState search;
-				search.change_ = g_change_table;
-				search.state_ = state_;
-				moves_.push_back(search);
-				for (int i = 1; i < depth; ++i) {
-					search.change_ = g_change_table;
-					changeState(search.change_, search.state_, search.state_);
-					moves_.push_back(search);
-				}
-				for(;;) {
-					auto& move = moves_[depth-1];
-					CubeState test;
-					changeState(move.change_, move.state_, test);
-					correctness = checkCorrectness(test);
-					//auto s = buildSymbolList();
-					//LOG("=TSC= list=" << s << "correctness=" << correctness);
-					if (correctness > correctness_) {
-						found = true;
-						break;
-					}
-
-					bool try_again = false;
-					for (int i = depth-1; i >= 0; --i) {
-						auto& move = moves_[i];
-						auto change = move.change_;
-						++change;
-						if (change->symbol_) {
-							try_again = true;
-						} else {
-							change = g_change_table;
-						}
-						move.change_ = change;
-						if (try_again) {
-							for (++i; i < depth; ++i) {
-								auto& move1 = moves_[i];
-								changeState(move.change_, move.state_, move1.state_);
-							}
-							break;
-						}
-					}
-					if (try_again == false) {
-						break;
-					}
-				}
-				if (found) {
-					break;
-				}
-			}
-			if (found) {
-                auto s = buildSymbolList();
-                LOG("Improve from " << correctness_ << " to " << correctness << " with moves: " << s);
-			} else {
-				moves_.clear();
-				LOG("No improvement found in " << kSearchDepth << " moves.");
-			}
-		}
-
-		std::string buildSymbolList() noexcept {
-			std::string s;
-			int n = moves_.size();
-			for (int i = 0; i < n; ++i) {
-				auto move = moves_[i];
-				s += move.change_->text_;
-				s += " ";
-			}
-			return s;
-		}
-
 		void logState(
 			const CubeState& state
 		) noexcept {
@@ -17,6 +17,13 @@ public:
     static Render *create() noexcept;
     virtual ~Render() noexcept;
 
+    // png prefix or video stream.
+    // see FrameCapture::setOutput.
+    virtual void setCapture(const char *name) noexcept = 0;
+    // log frame stats. the overlay shows frame times on screen.
+    virtual void setStats(bool overlay) noexcept = 0;
+    // the solver's pruning table file.
+    virtual void setTables(const char *filename) noexcept = 0;
     virtual void init(int width, int height) noexcept = 0;
     virtual void exit() noexcept = 0;
     virtual void draw() noexcept = 0;
@@ -0,0 +1,313 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+solve the rubik's cube in the background.
+
+render thread               worker thread
+--------------------        --------------------
+                            build tables
+solve(state)
+    cancel old search
+    post request
+                            wait for request
+                            two phase search
+poll()                          check cancelled
+                            convert to key presses
+                            post moves
+    take moves
+    turn the cube
+keyPressed()
+    cancel
+
+the search checks for cancellation every 1024 nodes.
+**/
+
+#include "solver.h"
+#include "twophase.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+
+/*
+the request and the results.
+every request has a new generation.
+the worker only posts results for the current generation.
+*/
+class SolverQueue : public agm::Container {
+public:
+    SolverQueue() noexcept :
+        agm::Container("SolverQueue") {
+    }
+
+    virtual ~SolverQueue() = default;
+
+    std::atomic<int> generation_{0};
+    bool has_request_ = false;
+    bool unblocked_ = false;
+    CubeState request_;
+    std::vector<const StateChange *> moves_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    /*
+    called by render thread.
+    */
+    void post(
+        const CubeState& state
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++generation_;
+            request_ = state;
+            has_request_ = true;
+            moves_.clear();
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by render thread.
+    */
+    void cancel() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++generation_;
+        has_request_ = false;
+        moves_.clear();
+    }
+
+    /*
+    called by worker thread.
+    waits for a request.
+    returns false when unblocked.
+    */
+    bool wait(
+        CubeState& state,
+        int& generation
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (has_request_ == false && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (unblocked_) {
+            return false;
+        }
+        has_request_ = false;
+        state = request_;
+        generation = generation_;
+        return true;
+    }
+
+    /*
+    called by worker thread.
+    checked often. no lock.
+    */
+    bool isCancelled(
+        int generation
+    ) noexcept {
+        return generation != generation_.load(std::memory_order_relaxed);
+    }
+
+    /*
+    called by worker thread.
+    */
+    void postMoves(
+        int generation,
+        const std::vector<const StateChange *>& moves
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (generation != generation_) {
+            return;
+        }
+        for (auto change : moves) {
+            moves_.push_back(change);
+        }
+    }
+
+    /*
+    called by render thread.
+    */
+    void takeMoves(
+        std::vector<const StateChange *>& moves
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto change : moves_) {
+            moves.push_back(change);
+        }
+        moves_.clear();
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+            ++generation_;
+        }
+        cv_.notify_all();
+    }
+};
+
+namespace {
+    class SolverWorker : public agm::Thread {
+    public:
+        SolverWorker(
+            SolverQueue *queue,
+            const char *tables
+        ) noexcept :
+            agm::Thread("SolverWorker"),
+            queue_(queue),
+            tables_(tables ? tables : "") {
+        }
+
+        virtual ~SolverWorker() = default;
+
+        SolverQueue *queue_;
+        std::string tables_;
+        int generation_ = 0;
+        CubeState state_;
+        bool ready_ = false;
+        MoveTables move_tables_;
+        PruneTables prune_tables_;
+        TwoPhase two_phase_{move_tables_, prune_tables_};
+
+        virtual void runOnce() noexcept {
+            /// build the tables before the first request.
+            if (ready_ == false) {
+                buildTables();
+                ready_ = true;
+            }
+
+            auto good = queue_->wait(state_, generation_);
+            if (good == false) {
+                return;
+            }
+            CubieCube cube;
+            int rotation = 0;
+            good = cube.fromState(state_, &rotation);
+            if (good == false) {
+                LOG("Not a real cube.");
+                return;
+            }
+            if (cube.isSolved() && rotation == 0) {
+                LOG("It's solved!");
+                return;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<int> solution;
+            auto found = two_phase_.solve(cube, solution);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            if (queue_->isCancelled(generation_)) {
+                LOG("Search cancelled.");
+                return;
+            }
+            if (found == false) {
+                LOG("No solution found in " << two_phase_.max_length_ << " moves.");
+                return;
+            }
+
+            std::vector<const StateChange *> changes;
+            movesToChanges(rotation, solution, changes);
+            LOG("Solved in " << solution.size() << " moves: " << buildMoveList(solution));
+            LOG("changes=" << changes.size() << " nodes=" << two_phase_.nodes_ << " ms=" << ms);
+            queue_->postMoves(generation_, changes);
+        }
+
+        void buildTables() noexcept {
+            auto start = std::chrono::steady_clock::now();
+            move_tables_.init();
+            /// map the pruning tables if they were generated.
+            auto good = false;
+            if (tables_.empty() == false) {
+                good = prune_tables_.load(tables_.c_str());
+            }
+            if (good == false) {
+                LOG("Building pruning tables. Run rubiks --gen-tables to save them.");
+                prune_tables_.init(move_tables_);
+            }
+            two_phase_.init(0);
+            two_phase_.cancelled_ = [this]() {
+                return queue_->isCancelled(generation_);
+            };
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            LOG("tables ms=" << ms);
+        }
+
+        std::string buildMoveList(
+            const std::vector<int>& moves
+        ) noexcept {
+            std::string s;
+            for (auto m : moves) {
+                s += g_move_names[m];
+                s += " ";
+            }
+            return s;
+        }
+    };
+}
+
+Solver::Solver() noexcept {
+}
+
+Solver::~Solver() noexcept {
+    exit();
+}
+
+void Solver::init(
+    const char *tables
+) noexcept {
+    exit();
+
+    queue_ = new(std::nothrow) SolverQueue;
+    containers_.push_back(queue_);
+    threads_.push_back(new(std::nothrow) SolverWorker(queue_, tables));
+    agm::Thread::startAll(threads_, containers_);
+}
+
+void Solver::solve(
+    const CubeState& state
+) noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+    queue_->post(state);
+}
+
+void Solver::cancel() noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+    queue_->cancel();
+}
+
+void Solver::poll(
+    std::vector<const StateChange *>& moves
+) noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+    queue_->takeMoves(moves);
+}
+
+void Solver::exit() noexcept {
+    if (queue_ == nullptr) {
+        return;
+    }
+
+    // deletes the queue.
+    agm::Thread::stopAll(threads_, containers_);
+    threads_.clear();
+    containers_.clear();
+    queue_ = nullptr;
+}
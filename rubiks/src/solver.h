@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+solve the rubik's cube in the background.
+
+the search runs on a worker thread.
+the render thread keeps drawing at 60 fps.
+the worker builds its tables when it starts.
+the pruning tables are mapped from a file if there is one.
+a search takes about a tenth of a second.
+see TwoPhase.
+
+the worker posts the moves as key presses.
+the render thread polls for them once per frame.
+
+solve or cancel abandons the search in progress.
+moves from an abandoned search are never returned.
+**/
+
+#include "cube.h"
+
+#include <vector>
+
+
+namespace agm {
+    class Container;
+    class Thread;
+}
+class SolverQueue;
+
+class Solver {
+public:
+    Solver() noexcept;
+    Solver(const Solver &) = delete;
+    ~Solver() noexcept;
+
+    // starts the worker.
+    // tables is the pruning table file. may be null.
+    void init(const char *tables) noexcept;
+
+    // cancels the current search.
+    // starts searching from the given state.
+    void solve(const CubeState& state) noexcept;
+
+    // cancels the current search.
+    void cancel() noexcept;
+
+    // call once per frame.
+    // appends the moves posted since the last poll.
+    void poll(std::vector<const StateChange *>& moves) noexcept;
+
+    // stops the worker.
+    void exit() noexcept;
+
+private:
+    SolverQueue *queue_ = nullptr;
+    std::vector<agm::Thread *> threads_;
+    std::vector<agm::Container *> containers_;
+};
@@ -0,0 +1,614 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+kociemba's two phase solver.
+
+solve
+    for each phase 1 depth
+        list the first two moves
+        post pass
+                                    every thread
+                                    take a move pair
+                                    search1
+                                        prune by twist x slice and flip x slice
+                                        phase 1 solved
+                                            startPhase2
+                                                apply the phase 1 moves to the cube
+                                                for each phase 2 depth
+                                                    search2
+                                                        skip states in the table
+                                                        prune by corners x slice and edges x slice
+                                                        remember states with no solution
+                                                remember the solution if it's shorter
+        wait for all threads
+
+consecutive moves of the same face are skipped.
+so are D then U. L then R. B then F.
+they commute with the other order.
+
+a table entry says there's no phase 2 solution
+of exactly togo moves from this state after this face.
+that's true for every cube.
+so the table is never cleared.
+entries are one 64 bit word holding the whole key.
+so a thread never sees half an entry.
+and a collision just replaces the old entry.
+**/
+
+#include "twophase.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+
+namespace {
+    // phase 2 never needs more than 18 moves.
+    const int kMaxPhase2 = 18;
+    const int kCheckNodes = 1024;
+    const int kMaxMoves = 40;
+    // split each phase 1 depth by this many moves.
+    const int kPrefixLength = 2;
+    const int kMaxThreads = 8;
+    // 8 MB.
+    const int kTableBits = 20;
+    // smaller subtrees are faster to search than to look up.
+    const int kMinTableDepth = 4;
+
+    bool isPhase2Move(
+        int move
+    ) noexcept {
+        for (int i = 0; i < kNumPhase2Moves; ++i) {
+            if (g_phase2_moves[i] == move) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// U R F then D L B.
+    bool skipFace(
+        int face,
+        int last_face
+    ) noexcept {
+        return (face == last_face) || (face + 3 == last_face);
+    }
+
+    /*
+    corners 16 bits. edges 16 bits. slice perm 5 bits.
+    last face 3 bits. togo 5 bits. plus a bit so it's never 0.
+    */
+    std::uint64_t tableKey(
+        int corners,
+        int edges,
+        int slice_perm,
+        int last_face,
+        int togo
+    ) noexcept {
+        std::uint64_t key = 1;
+        key = (key << 5) | togo;
+        key = (key << 3) | (last_face + 1);
+        key = (key << 5) | slice_perm;
+        key = (key << 16) | edges;
+        key = (key << 16) | corners;
+        return key;
+    }
+}
+
+/*
+the state shared by the search threads.
+one pass per phase 1 depth.
+*/
+class TwoPhaseShared : public agm::Container {
+public:
+    TwoPhaseShared() noexcept :
+        agm::Container("TwoPhaseShared"),
+        table_(std::size_t(1) << kTableBits) {
+    }
+
+    virtual ~TwoPhaseShared() = default;
+
+    /// the settings from TwoPhase.
+    int max_length_ = 0;
+    int stop_length_ = 0;
+    int max_ms_ = 0;
+    const std::function<bool()> *cancelled_ = nullptr;
+
+    /// the cube to solve.
+    CubieCube cube_;
+    int twist_ = 0;
+    int flip_ = 0;
+    int slice_ = 0;
+    std::chrono::steady_clock::time_point start_;
+
+    /// the pass.
+    int depth1_ = 0;
+    int prefix_length_ = 0;
+    std::vector<int> prefixes_;
+    std::atomic<int> next_prefix_{0};
+
+    /// the results.
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> was_cancelled_{false};
+    std::atomic<int> best_length_{0};
+    std::atomic<long long> nodes_{0};
+    std::vector<int> best_;
+    std::mutex best_mutex_;
+
+    std::vector<std::atomic<std::uint64_t>> table_;
+
+    /// the pool.
+    int generation_ = 0;
+    int working_ = 0;
+    bool unblocked_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    /*
+    called by master thread.
+    */
+    void post(
+        int nworkers
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            next_prefix_ = 0;
+            working_ = nworkers;
+            if (nworkers == 0) {
+                /// let the workers sleep.
+                return;
+            }
+            ++generation_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by worker threads.
+    waits for a new pass.
+    returns false when unblocked.
+    */
+    bool wait(
+        int &generation
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (generation_ == generation && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (unblocked_) {
+            return false;
+        }
+        generation = generation_;
+        return true;
+    }
+
+    /*
+    called by worker threads.
+    */
+    void done() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            --working_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by master thread.
+    */
+    void waitDone() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (working_ > 0 && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+    }
+
+    /*
+    called by all threads.
+    keeps the solution if it's the shortest so far.
+    */
+    void postSolution(
+        const int *moves,
+        int length
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(best_mutex_);
+        if (length >= best_length_) {
+            return;
+        }
+        best_.assign(moves, moves + length);
+        best_length_ = length;
+        if (length <= stop_length_) {
+            stop_ = true;
+        }
+    }
+
+    bool isKnownFailure(
+        std::uint64_t key
+    ) noexcept {
+        auto& entry = table_[index(key)];
+        return entry.load(std::memory_order_relaxed) == key;
+    }
+
+    void addFailure(
+        std::uint64_t key
+    ) noexcept {
+        auto& entry = table_[index(key)];
+        entry.store(key, std::memory_order_relaxed);
+    }
+
+    static std::size_t index(
+        std::uint64_t key
+    ) noexcept {
+        return (key * 0x9E3779B97F4A7C15ull) >> (64 - kTableBits);
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+            stop_ = true;
+        }
+        cv_.notify_all();
+    }
+};
+
+/*
+the search state of one thread.
+*/
+class TwoPhaseSearch {
+public:
+    TwoPhaseSearch(
+        TwoPhaseShared *shared,
+        const MoveTables& moves,
+        const PruneTables& prune
+    ) noexcept :
+        shared_(shared),
+        mt_(moves),
+        pt_(prune) {
+    }
+
+    TwoPhaseSearch(const TwoPhaseSearch &) = delete;
+    ~TwoPhaseSearch() = default;
+
+    /*
+    called by all threads.
+    search the move pairs until there are none left.
+    */
+    void runPass() noexcept {
+        auto shared = shared_;
+        int plen = shared->prefix_length_;
+        int nprefixes = shared->prefixes_.size() / std::max(plen, 1);
+        if (plen == 0) {
+            nprefixes = 1;
+        }
+        nodes_ = 0;
+        for(;;) {
+            if (shared->stop_.load(std::memory_order_relaxed)) {
+                break;
+            }
+            int job = shared->next_prefix_.fetch_add(1);
+            if (job >= nprefixes) {
+                break;
+            }
+            int twist = shared->twist_;
+            int flip = shared->flip_;
+            int slice = shared->slice_;
+            int last_face = -1;
+            for (int i = 0; i < plen; ++i) {
+                int m = shared->prefixes_[job * plen + i];
+                moves_[i] = m;
+                twist = mt_.twist(twist, m);
+                flip = mt_.flip(flip, m);
+                slice = mt_.slice(slice, m);
+                last_face = m / 3;
+            }
+            search1(twist, flip, slice, plen, shared->depth1_ - plen, last_face);
+        }
+        shared->nodes_ += nodes_;
+    }
+
+private:
+    TwoPhaseShared *shared_;
+    const MoveTables& mt_;
+    const PruneTables& pt_;
+    long long nodes_ = 0;
+    int moves_[kMaxMoves];
+
+    bool isStopped() noexcept {
+        return shared_->stop_.load(std::memory_order_relaxed);
+    }
+
+    void search1(
+        int twist,
+        int flip,
+        int slice,
+        int depth,
+        int togo,
+        int last_face
+    ) noexcept {
+        if (isStopped()) {
+            return;
+        }
+        if ((++nodes_ % kCheckNodes) == 0) {
+            checkStop();
+        }
+        if (pt_.phase1(twist, flip, slice) > togo) {
+            return;
+        }
+        if (togo == 0) {
+            /// a shorter phase 1 already ended here.
+            if (depth > 0 && isPhase2Move(moves_[depth-1])) {
+                return;
+            }
+            startPhase2(depth);
+            return;
+        }
+        for (int m = 0; m < kNumMoves; ++m) {
+            int face = m / 3;
+            if (skipFace(face, last_face)) {
+                continue;
+            }
+            moves_[depth] = m;
+            search1(mt_.twist(twist, m), mt_.flip(flip, m), mt_.slice(slice, m),
+                depth + 1, togo - 1, face);
+            if (isStopped()) {
+                return;
+            }
+        }
+    }
+
+    void startPhase2(
+        int depth1
+    ) noexcept {
+        CubieCube cube = shared_->cube_;
+        for (int i = 0; i < depth1; ++i) {
+            cube.multiply(mt_.moves_[moves_[i]]);
+        }
+        int corners = cube.getCornerPerm();
+        int edges = cube.getEdgePerm();
+        int slice_perm = cube.getSlicePerm();
+        int last_face = (depth1 > 0) ? moves_[depth1-1] / 3 : -1;
+
+        /// another thread may find a shorter solution any time.
+        int best_length = shared_->best_length_.load(std::memory_order_relaxed);
+        int max_depth2 = std::min(best_length - 1 - depth1, kMaxPhase2);
+        for (int depth2 = pt_.phase2(corners, edges, slice_perm); depth2 <= max_depth2; ++depth2) {
+            auto found = search2(corners, edges, slice_perm, depth1, depth2, last_face);
+            if (isStopped()) {
+                return;
+            }
+            if (found) {
+                shared_->postSolution(moves_, depth1 + depth2);
+                return;
+            }
+        }
+    }
+
+    bool search2(
+        int corners,
+        int edges,
+        int slice_perm,
+        int depth,
+        int togo,
+        int last_face
+    ) noexcept {
+        if ((++nodes_ % kCheckNodes) == 0) {
+            checkStop();
+            if (isStopped()) {
+                return false;
+            }
+        }
+        if (togo == 0) {
+            return (corners == 0 && edges == 0 && slice_perm == 0);
+        }
+        if (pt_.phase2(corners, edges, slice_perm) > togo) {
+            return false;
+        }
+        std::uint64_t key = 0;
+        if (togo >= kMinTableDepth) {
+            key = tableKey(corners, edges, slice_perm, last_face, togo);
+            if (shared_->isKnownFailure(key)) {
+                return false;
+            }
+        }
+        for (int k = 0; k < kNumPhase2Moves; ++k) {
+            int m = g_phase2_moves[k];
+            int face = m / 3;
+            if (skipFace(face, last_face)) {
+                continue;
+            }
+            moves_[depth] = m;
+            auto found = search2(mt_.cornerPerm(corners, m), mt_.edgePerm(edges, m),
+                mt_.slicePerm(slice_perm, m), depth + 1, togo - 1, face);
+            if (found) {
+                return true;
+            }
+            if (isStopped()) {
+                /// the subtree wasn't finished.
+                return false;
+            }
+        }
+        if (key) {
+            shared_->addFailure(key);
+        }
+        return false;
+    }
+
+    void checkStop() noexcept {
+        auto shared = shared_;
+        if (*shared->cancelled_ && (*shared->cancelled_)()) {
+            shared->was_cancelled_ = true;
+            shared->stop_ = true;
+            return;
+        }
+        if (shared->best_length_.load(std::memory_order_relaxed) <= shared->max_length_) {
+            auto elapsed = std::chrono::steady_clock::now() - shared->start_;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            if (ms >= shared->max_ms_) {
+                shared->stop_ = true;
+            }
+        }
+    }
+};
+
+namespace {
+    class TwoPhaseWorker : public agm::Thread {
+    public:
+        TwoPhaseWorker(
+            TwoPhaseShared *shared,
+            const MoveTables& moves,
+            const PruneTables& prune
+        ) noexcept :
+            agm::Thread("TwoPhaseWorker"),
+            shared_(shared),
+            search_(shared, moves, prune) {
+        }
+
+        virtual ~TwoPhaseWorker() = default;
+
+        TwoPhaseShared *shared_;
+        TwoPhaseSearch search_;
+        int generation_ = 0;
+
+        virtual void runOnce() noexcept {
+            auto good = shared_->wait(generation_);
+            if (good == false) {
+                return;
+            }
+            search_.runPass();
+            shared_->done();
+        }
+    };
+
+    /*
+    every sequence of length moves
+    that doesn't repeat or reorder a face.
+    */
+    void listPrefixes(
+        int length,
+        int last_face,
+        std::vector<int>& prefix,
+        std::vector<int>& prefixes
+    ) noexcept {
+        if (length == 0) {
+            prefixes.insert(prefixes.end(), prefix.begin(), prefix.end());
+            return;
+        }
+        for (int m = 0; m < kNumMoves; ++m) {
+            int face = m / 3;
+            if (skipFace(face, last_face)) {
+                continue;
+            }
+            prefix.push_back(m);
+            listPrefixes(length - 1, face, prefix, prefixes);
+            prefix.pop_back();
+        }
+    }
+}
+
+TwoPhase::TwoPhase(
+    const MoveTables& moves,
+    const PruneTables& prune
+) noexcept :
+    mt_(moves),
+    pt_(prune) {
+}
+
+TwoPhase::~TwoPhase() noexcept {
+    exit();
+}
+
+void TwoPhase::init(
+    int nthreads
+) noexcept {
+    exit();
+
+    if (nthreads <= 0) {
+        nthreads = std::thread::hardware_concurrency();
+    }
+    nthreads = std::max(1, std::min(nthreads, kMaxThreads));
+
+    // the calling thread searches too.
+    nworkers_ = nthreads - 1;
+    shared_ = new(std::nothrow) TwoPhaseShared;
+    containers_.push_back(shared_);
+    search_ = new(std::nothrow) TwoPhaseSearch(shared_, mt_, pt_);
+    for (int i = 0; i < nworkers_; ++i) {
+        threads_.push_back(new(std::nothrow) TwoPhaseWorker(shared_, mt_, pt_));
+    }
+    agm::Thread::startAll(threads_, containers_);
+}
+
+void TwoPhase::exit() noexcept {
+    if (shared_ == nullptr) {
+        return;
+    }
+
+    // deletes the shared state.
+    agm::Thread::stopAll(threads_, containers_);
+    threads_.clear();
+    containers_.clear();
+    shared_ = nullptr;
+    delete search_;
+    search_ = nullptr;
+    nworkers_ = 0;
+}
+
+bool TwoPhase::solve(
+    const CubieCube& cube,
+    std::vector<int>& solution
+) noexcept {
+    if (shared_ == nullptr) {
+        init(1);
+    }
+
+    auto shared = shared_;
+    shared->max_length_ = max_length_;
+    shared->stop_length_ = stop_length_;
+    shared->max_ms_ = max_ms_;
+    shared->cancelled_ = &cancelled_;
+    shared->cube_ = cube;
+    shared->twist_ = cube.getTwist();
+    shared->flip_ = cube.getFlip();
+    shared->slice_ = cube.getSlice();
+    shared->start_ = std::chrono::steady_clock::now();
+    shared->stop_ = false;
+    shared->was_cancelled_ = false;
+    shared->best_length_ = max_length_ + 1;
+    shared->nodes_ = 0;
+    shared->best_.clear();
+
+    std::vector<int> prefix;
+    for (int depth1 = 0; depth1 < shared->best_length_ && shared->stop_ == false; ++depth1) {
+        int plen = std::min(depth1, kPrefixLength);
+        if (plen != shared->prefix_length_ || shared->prefixes_.empty()) {
+            shared->prefixes_.clear();
+            listPrefixes(plen, -1, prefix, shared->prefixes_);
+            shared->prefix_length_ = plen;
+        }
+        shared->depth1_ = depth1;
+        /// the short depths aren't worth waking the workers.
+        int nworkers = (plen < kPrefixLength) ? 0 : nworkers_;
+        shared->post(nworkers);
+        search_->runPass();
+        shared->waitDone();
+    }
+
+    nodes_ = shared->nodes_;
+    if (shared->was_cancelled_) {
+        solution.clear();
+        return false;
+    }
+    solution = shared->best_;
+    return (shared->best_length_ <= max_length_);
+}
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+kociemba's two phase solver.
+
+phase 1 moves the cube into the group generated by
+U D R2 L2 F2 B2.
+where the corners and edges are oriented
+and the slice edges are in the slice.
+phase 2 solves the cube using only those moves.
+
+both phases are iterative deepening a*.
+the pruning tables are admissible lower bounds.
+
+the first solution is usually 25ish moves.
+found in a few milliseconds.
+the search continues with longer phase 1 and shorter phase 2
+until the solution is short enough or time runs out.
+
+the search runs on a pool of threads.
+each phase 1 depth is split by its first two moves.
+the threads take the move pairs one at a time.
+and share the length of the best solution so far.
+
+phase 2 states that have no solution are remembered
+in a lock free transposition table.
+so the other threads and later phase 1 paths skip them.
+**/
+
+#include "coord.h"
+#include "prune.h"
+
+#include <functional>
+#include <vector>
+
+
+namespace agm {
+    class Container;
+    class Thread;
+}
+class TwoPhaseShared;
+class TwoPhaseSearch;
+
+class TwoPhase {
+public:
+    TwoPhase(const MoveTables& moves, const PruneTables& prune) noexcept;
+    TwoPhase(const TwoPhase &) = delete;
+    ~TwoPhase() noexcept;
+
+    // never longer than this.
+    int max_length_ = 30;
+    // stop at the first solution this short.
+    int stop_length_ = 20;
+    // stop improving after this many milliseconds.
+    int max_ms_ = 100;
+    // checked every so often. return true to abandon the search.
+    // called from every search thread.
+    std::function<bool()> cancelled_;
+
+    // nodes visited by the last solve.
+    long long nodes_ = 0;
+
+    // starts the search threads.
+    // 0 means one per core.
+    // solve calls init(1) if nobody else did.
+    void init(int nthreads) noexcept;
+
+    // stops the search threads.
+    void exit() noexcept;
+
+    // returns false if cancelled before a solution was found.
+    bool solve(const CubieCube& cube, std::vector<int>& solution) noexcept;
+
+private:
+    const MoveTables& mt_;
+    const PruneTables& pt_;
+    TwoPhaseShared *shared_ = nullptr;
+    TwoPhaseSearch *search_ = nullptr;
+    int nworkers_ = 0;
+    std::vector<agm::Thread *> threads_;
+    std::vector<agm::Container *> containers_;
+};
@@ -16,7 +16,7 @@ public:
     static RubiksWindow *create() noexcept;
     virtual ~RubiksWindow() noexcept;
 
-    virtual void init() noexcept = 0;
+    virtual void init(bool headless, const char *capture, bool stats, bool overlay, const char *tables) noexcept = 0;
     virtual void exit() noexcept = 0;
     virtual void run() noexcept = 0;
 };
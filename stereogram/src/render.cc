@@ -4,15 +4,25 @@ Copyright (C) 2012-2020 tim cotter. All rights reserved.
 
 /**
 stereogram example.
+
+two side by side views for cross-eyed viewing.
+or a single image random dot stereogram.
+the sirds mode renders the sphere's depth to an offscreen buffer.
+reads it back.
+generates the dots on the cpu.
+and blits them to the window.
 **/
 
 #include "render.h"
+#include "sirds.h"
 
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 #include <aggiornamento/opengl.h>
-#include <common/png.h>
+#include <common/capture.h>
 #include <common/sphere.h>
+#include <common/stats.h>
+#include <common/texture.h>
 
 #include <GLES3/gl3.h>
 
@@ -21,8 +31,6 @@ stereogram example.
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <sstream>
-#include <iomanip>
 
 
 namespace {
@@ -57,6 +65,33 @@ namespace {
         }
     )shader_code";
 
+    /*
+    the depth is 0.5 at the rim and 1.0 in the middle.
+    the background is cleared to 0.
+    so the sphere stands out from the background.
+    */
+    auto g_depth_vertex_source =R"shader_code(
+        #version 310 es
+        layout (location = 0) in mediump vec3 vertex_pos_in;
+        out mediump float depth;
+        uniform mat4 model_mat;
+        uniform mat4 proj_view_mat;
+        void main() {
+            vec4 world_pos = model_mat * vec4(vertex_pos_in, 1.0f);
+            gl_Position = proj_view_mat * world_pos;
+            depth = 0.5f + 0.5f * world_pos.z;
+        }
+    )shader_code";
+
+    auto g_depth_fragment_source = R"shader_code(
+        #version 310 es
+        in mediump float depth;
+        out mediump vec4 color_out;
+        void main() {
+            color_out = vec4(depth, depth, depth, 1.0f);
+        }
+    )shader_code";
+
     class SphereTexture {
     public:
         SphereTexture() = default;
@@ -90,9 +125,41 @@ namespace {
         int num_indexes_ = 0;
         float angle_ = 0.0f;
         glm::mat4 rotxz_;
-        int frame_count_ = 0;
+        FrameCapture capture_{"output/world", 24*60};
+        bool capture_on_ = false;
+        FrameStats stats_;
+        TextureStreamer streamer_;
+        bool sirds_on_ = false;
+        int sirds_width_ = 0;
+        int sirds_height_ = 0;
+        GLuint depth_vertex_shader_ = 0;
+        GLuint depth_fragment_shader_ = 0;
+        GLuint depth_program_ = 0;
+        GLuint depth_model_mat_loc_ = 0;
+        GLuint depth_proj_view_mat_loc_ = 0;
+        GLuint depth_framebuffer_ = 0;
+        GLuint depth_color_buffer_ = 0;
+        GLuint depth_depth_buffer_ = 0;
+        GLuint sirds_framebuffer_ = 0;
+        GLuint sirds_texture_ = 0;
+        std::vector<GLubyte> depth_pixels_;
+        std::vector<GLubyte> sirds_pixels_;
+        Sirds sirds_;
         int update_frame_ = 0;
 
+        virtual void setCapture(
+            const char *name
+        ) noexcept {
+            capture_.setOutput(name);
+            capture_on_ = true;
+        }
+
+        virtual void setStats(
+            bool overlay
+        ) noexcept {
+            stats_.enable(overlay);
+        }
+
         virtual void init(
             int width,
             int height
@@ -200,19 +267,7 @@ namespace {
 
             loadPng(kWorldTextureFilename, &world_texture_);
 
-            Png png;
-            png.read(kStarTextureFilename);
-            glGenTextures(1, &star_texture_);
-            glBindTexture(GL_TEXTURE_2D, star_texture_);
-            {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, png.wd_, png.ht_, 0, GL_RGB, GL_UNSIGNED_BYTE, png.data_);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glGenerateMipmap(GL_TEXTURE_2D);
-            }
-            glBindTexture(GL_TEXTURE_2D, 0);
+            streamer_.load(kStarTextureFilename, 1, &star_texture_, true);
             LOG("star_texture=" << star_texture_);
 
             glUseProgram(program_);
@@ -245,6 +300,10 @@ namespace {
         }
 
         virtual void exit() noexcept {
+            stats_.exit();
+            capture_.exit();
+            streamer_.exit();
+            exitSirds();
             if (program_) {
                 if (fragment_shader_) {
                     glDetachShader(program_, fragment_shader_);
@@ -301,18 +360,47 @@ namespace {
             }
         }
 
+        virtual void setSirds(
+            bool sirds
+        ) noexcept {
+            sirds_on_ = sirds;
+        }
+
         virtual void draw() noexcept {
-            glClearColor(0.2f, 0.0f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            stats_.beginFrame();
+            stats_.stage("textures");
+            streamer_.update();
+
+            if (sirds_on_) {
+                drawSirds();
+            } else {
+                stats_.stage("draw");
+                drawPair();
+            }
 
-			/// redraw the left eye the same as last frame.
-			drawWorld(update_frame_);
+            stats_.stage("capture");
+            if (capture_on_) {
+                captureFrame();
+            }
+            stats_.endFrame(width_, height_);
+        }
 
+        void spin() noexcept {
             float pi = (float) acos(-1.0f);
             angle_ += 2.0f*pi/60.0f/24.0f;  // 24 hours in 24 seconds.
             if (angle_ >= 2.0f*pi) {
                 angle_ -= 2.0f*pi;
             }
+        }
+
+        void drawPair() noexcept {
+            glClearColor(0.2f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			/// redraw the left eye the same as last frame.
+			drawWorld(update_frame_);
+
+            spin();
 
 			//drawWorld(update_frame_);
 
@@ -328,8 +416,172 @@ namespace {
             glDisableVertexAttribArray(1);
             glDisableVertexAttribArray(0);
             glUseProgram(0);
+        }
+
+        void drawSirds() noexcept {
+            if (sirds_width_ != width_ || sirds_height_ != height_) {
+                exitSirds();
+                initSirds();
+            }
+
+            spin();
+
+            // render the depth offscreen.
+            stats_.stage("depth");
+            glBindFramebuffer(GL_FRAMEBUFFER, depth_framebuffer_);
+            glViewport(0, 0, width_, height_);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            drawDepth();
+            stats_.stage("readback");
+            glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, depth_pixels_.data());
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            stats_.stage("sirds");
+            sirds_.generate(depth_pixels_.data(), sirds_pixels_.data());
+
+            // copy the dots to the window.
+            stats_.stage("upload");
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glBindTexture(GL_TEXTURE_2D, sirds_texture_);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, sirds_pixels_.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, sirds_framebuffer_);
+            glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        }
+
+        void drawDepth() noexcept {
+            glm::mat4 model_mat = glm::rotate(
+                glm::mat4(),
+                angle_,
+                glm::vec3(0.0f, 1.0f, 0.0f)  // around y axis
+            );
+
+            glm::mat4 view_mat = glm::lookAt(
+                glm::vec3(0.0f, 0.0f, 30.0f),  // camera location
+                glm::vec3(0.0f, 0.0f, 0.0f),  // looking at
+                glm::vec3(0.0f, 1.0f, 0.0f)   // up direction
+            );
+            glm::mat4 proj_mat = glm::perspective(
+                glm::radians(6.0f),  // fov
+                float(width_)/float(height_),   // aspect ratio
+                1.0f,  // near clipping plane
+                100.0f  // far  clipping plane
+            );
+            glm::mat4 proj_view_mat = proj_mat * view_mat;
+
+            glUseProgram(depth_program_);
+            glUniformMatrix4fv(depth_model_mat_loc_, 1, GL_FALSE, &model_mat[0][0]);
+            glUniformMatrix4fv(depth_proj_view_mat_loc_, 1, GL_FALSE, &proj_view_mat[0][0]);
+            glEnableVertexAttribArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, world_vertex_buffer_);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, world_index_buffer_);
+            glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
+
+            model_mat = model_mat * rotxz_;
+            glUniformMatrix4fv(depth_model_mat_loc_, 1, GL_FALSE, &model_mat[0][0]);
+            glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDisableVertexAttribArray(0);
+            glUseProgram(0);
+        }
+
+        void initSirds() noexcept {
+            sirds_width_ = width_;
+            sirds_height_ = height_;
+
+            depth_vertex_shader_ = agm::gl::compileShader(GL_VERTEX_SHADER, g_depth_vertex_source);
+            LOG("depth_vertex_shader=" << depth_vertex_shader_);
+            depth_fragment_shader_ = agm::gl::compileShader(GL_FRAGMENT_SHADER, g_depth_fragment_source);
+            LOG("depth_fragment_shader=" << depth_fragment_shader_);
+            depth_program_ = agm::gl::linkProgram(depth_vertex_shader_, depth_fragment_shader_);
+            LOG("depth_program=" << depth_program_);
+            depth_model_mat_loc_ = glGetUniformLocation(depth_program_, "model_mat");
+            depth_proj_view_mat_loc_ = glGetUniformLocation(depth_program_, "proj_view_mat");
+
+            glGenRenderbuffers(1, &depth_color_buffer_);
+            glBindRenderbuffer(GL_RENDERBUFFER, depth_color_buffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+            glGenRenderbuffers(1, &depth_depth_buffer_);
+            glBindRenderbuffer(GL_RENDERBUFFER, depth_depth_buffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width_, height_);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glGenFramebuffers(1, &depth_framebuffer_);
+            glBindFramebuffer(GL_FRAMEBUFFER, depth_framebuffer_);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, depth_color_buffer_);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_depth_buffer_);
+            auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            if (status != GL_FRAMEBUFFER_COMPLETE) {
+                LOG("*** ERROR *** depth framebuffer incomplete status=" << agm::log::AsHex(status));
+            }
 
-            //captureFrame();
+            glGenTextures(1, &sirds_texture_);
+            glBindTexture(GL_TEXTURE_2D, sirds_texture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width_, height_, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glGenFramebuffers(1, &sirds_framebuffer_);
+            glBindFramebuffer(GL_FRAMEBUFFER, sirds_framebuffer_);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sirds_texture_, 0);
+            status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            if (status != GL_FRAMEBUFFER_COMPLETE) {
+                LOG("*** ERROR *** sirds framebuffer incomplete status=" << agm::log::AsHex(status));
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            depth_pixels_.resize(4 * width_ * height_);
+            sirds_pixels_.resize(3 * width_ * height_);
+            sirds_.init(width_, height_);
+        }
+
+        void exitSirds() noexcept {
+            sirds_.exit();
+            if (sirds_framebuffer_) {
+                glDeleteFramebuffers(1, &sirds_framebuffer_);
+                sirds_framebuffer_ = 0;
+            }
+            if (sirds_texture_) {
+                glDeleteTextures(1, &sirds_texture_);
+                sirds_texture_ = 0;
+            }
+            if (depth_framebuffer_) {
+                glDeleteFramebuffers(1, &depth_framebuffer_);
+                depth_framebuffer_ = 0;
+            }
+            if (depth_depth_buffer_) {
+                glDeleteRenderbuffers(1, &depth_depth_buffer_);
+                depth_depth_buffer_ = 0;
+            }
+            if (depth_color_buffer_) {
+                glDeleteRenderbuffers(1, &depth_color_buffer_);
+                depth_color_buffer_ = 0;
+            }
+            if (depth_program_) {
+                if (depth_fragment_shader_) {
+                    glDetachShader(depth_program_, depth_fragment_shader_);
+                }
+                if (depth_vertex_shader_) {
+                    glDetachShader(depth_program_, depth_vertex_shader_);
+                }
+                glDeleteProgram(depth_program_);
+                depth_program_ = 0;
+            }
+            if (depth_fragment_shader_) {
+                glDeleteShader(depth_fragment_shader_);
+                depth_fragment_shader_ = 0;
+            }
+            if (depth_vertex_shader_) {
+                glDeleteShader(depth_vertex_shader_);
+                depth_vertex_shader_ = 0;
+            }
+            sirds_width_ = 0;
+            sirds_height_ = 0;
         }
 
         void drawWorld(
@@ -367,11 +619,13 @@ namespace {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, world_index_buffer_);
             glBindTexture(GL_TEXTURE_2D, world_texture_.front_);
             glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
 
             model_mat = model_mat * rotxz_;
             glUniformMatrix4fv(model_mat_loc_, 1, GL_FALSE, &model_mat[0][0]);
             glBindTexture(GL_TEXTURE_2D, world_texture_.back_);
             glDrawElements(GL_TRIANGLES, num_indexes_, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(num_indexes_ / 3);
         }
 
         void drawStars() noexcept {
@@ -417,6 +671,7 @@ namespace {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, star_index_buffer_);
             glBindTexture(GL_TEXTURE_2D, star_texture_);
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+            stats_.countDraw(2);
         }
 
         virtual void resize(
@@ -439,39 +694,15 @@ namespace {
             const char *filename,
             SphereTexture *texture
         ) noexcept {
-            Png png;
-            png.read(filename);
-            auto ht2 = png.ht_ / 2;
-            auto data = png.data_;
-            texture->front_ = loadTexture(png.wd_, ht2, data);
+            // the top and bottom strips.
+            GLuint textures[2];
+            streamer_.load(filename, 2, textures, false);
+            texture->front_ = textures[0];
             LOG("front=" << texture->front_);
-            data += png.stride_ * ht2;
-            texture->back_ = loadTexture(png.wd_, ht2, data);
+            texture->back_ = textures[1];
             LOG("back=" << texture->back_);
         }
 
-        GLuint loadTexture(
-            int width,
-            int height,
-            GLubyte *data
-        ) noexcept {
-            GLuint texture = 0;
-            glGenTextures(1, &texture);
-
-            glBindTexture(GL_TEXTURE_2D, texture);
-            {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glGenerateMipmap(GL_TEXTURE_2D);
-            }
-            glBindTexture(GL_TEXTURE_2D, 0);
-
-            return texture;
-        }
-
         int calcSegments(
             int width,
             int height
@@ -483,32 +714,7 @@ namespace {
         }
 
         void captureFrame() noexcept {
-            if (frame_count_ >= 24*60) {
-                return;
-            }
-
-            Png png_flipped;
-            png_flipped.init(width_, height_);
-            glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, png_flipped.data_);
-            //png_flipped.write("flipped.png");
-
-            Png png;
-            png.init(width_, height_);
-            auto src = png_flipped.data_ + (height_ - 1)*png_flipped.stride_;
-            auto dst = png.data_;
-            for (int i = 0; i < height_; ++i) {
-                std::memcpy(dst, src, png.stride_);
-                src -= png_flipped.stride_;
-                dst += png.stride_;
-            }
-
-            std::stringstream ss;
-            ss << "output/world" << std::setfill('0') << std::setw(5) << frame_count_
-                << std::setfill(' ') << std::setw(0) << ".png";
-            LOG("ss=" << ss.str().c_str());
-            png.write(ss.str().c_str());
-
-            ++frame_count_;
+            capture_.capture(width_, height_);
         }
     };
 }
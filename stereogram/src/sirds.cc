@@ -0,0 +1,324 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+/**
+single image random dot stereogram.
+
+render thread               worker threads
+--------------------        --------------------
+generate()
+    post frame
+                            wait for frame
+    take rows               take rows
+        link constraints        link constraints
+        color right to left     color right to left
+                            done
+    wait for workers
+
+the depth to separation pass is a straight float loop.
+which the compiler turns into simd.
+linking the constraints is inherently serial within a row.
+**/
+
+#include "sirds.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/container.h>
+#include <aggiornamento/log.h>
+#include <aggiornamento/thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+
+namespace {
+    // the depth of field as a fraction of the viewing distance.
+    const float kDepthOfField = 1.0f / 3.0f;
+    // the eye separation is a fraction of the width.
+    const int kEyeSeparationDivisor = 8;
+    const int kMaxWorkers = 8;
+
+    class Scanline {
+    public:
+        Scanline() = default;
+        Scanline(const Scanline &) = delete;
+        ~Scanline() = default;
+
+        int width_ = 0;
+        float eye_ = 0.0f;
+        std::vector<float> z_;
+        std::vector<int> sep_;
+        std::vector<int> same_;
+
+        void init(
+            int width
+        ) noexcept {
+            width_ = width;
+            eye_ = float(width / kEyeSeparationDivisor);
+            z_.resize(width);
+            sep_.resize(width);
+            same_.resize(width);
+        }
+
+        void run(
+            const std::uint8_t *depth,
+            std::uint8_t *rgb,
+            int row
+        ) noexcept {
+            int wd = width_;
+            auto z = z_.data();
+            auto sep = sep_.data();
+            auto same = same_.data();
+
+            for (int x = 0; x < wd; ++x) {
+                z[x] = float(depth[4*x]) * (1.0f / 255.0f);
+            }
+            auto mu = kDepthOfField;
+            auto eye = eye_;
+            for (int x = 0; x < wd; ++x) {
+                auto muz = mu * z[x];
+                sep[x] = int((1.0f - muz) * eye / (2.0f - muz) + 0.5f);
+            }
+            for (int x = 0; x < wd; ++x) {
+                same[x] = x;
+            }
+
+            for (int x = 0; x < wd; ++x) {
+                auto s = sep[x];
+                auto left = x - s / 2;
+                auto right = left + s;
+                if (left < 0 || right >= wd) {
+                    continue;
+                }
+                // walk the chain until left and right are linked.
+                auto k = same[left];
+                while (k != left && k != right) {
+                    if (k < right) {
+                        left = k;
+                    } else {
+                        left = right;
+                        right = k;
+                    }
+                    k = same[left];
+                }
+                same[left] = right;
+            }
+
+            // the same dots every frame. less flicker.
+            std::uint32_t seed = 0x9E3779B9u * std::uint32_t(row + 1);
+            for (int x = wd - 1; x >= 0; --x) {
+                auto dst = rgb + 3*x;
+                if (same[x] == x) {
+                    seed ^= seed << 13;
+                    seed ^= seed >> 17;
+                    seed ^= seed << 5;
+                    dst[0] = std::uint8_t(seed);
+                    dst[1] = std::uint8_t(seed >> 8);
+                    dst[2] = std::uint8_t(seed >> 16);
+                } else {
+                    auto src = rgb + 3*same[x];
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                }
+            }
+        }
+    };
+}
+
+/*
+the frame being generated.
+hands out rows to the workers.
+*/
+class SirdsFrame : public agm::Container {
+public:
+    SirdsFrame(
+        int width,
+        int height
+    ) noexcept :
+        agm::Container("SirdsFrame"),
+        width_(width),
+        height_(height) {
+        line_.init(width);
+    }
+
+    virtual ~SirdsFrame() = default;
+
+    int width_;
+    int height_;
+    const std::uint8_t *depth_ = nullptr;
+    std::uint8_t *rgb_ = nullptr;
+    std::atomic<int> next_row_{0};
+    int generation_ = 0;
+    int working_ = 0;
+    bool unblocked_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // the render thread's scanline.
+    Scanline line_;
+
+    /*
+    called by render thread.
+    */
+    void post(
+        const std::uint8_t *depth,
+        std::uint8_t *rgb,
+        int nworkers
+    ) noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            depth_ = depth;
+            rgb_ = rgb;
+            next_row_ = 0;
+            working_ = nworkers;
+            ++generation_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by worker threads.
+    waits for a new frame.
+    returns false when unblocked.
+    */
+    bool wait(
+        int &generation
+    ) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (generation_ == generation && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+        if (unblocked_) {
+            return false;
+        }
+        generation = generation_;
+        return true;
+    }
+
+    /*
+    called by all threads.
+    */
+    void runRows(
+        Scanline &line
+    ) noexcept {
+        for(;;) {
+            int row = next_row_.fetch_add(1);
+            if (row >= height_) {
+                break;
+            }
+            line.run(depth_ + 4*width_*row, rgb_ + 3*width_*row, row);
+        }
+    }
+
+    /*
+    called by worker threads.
+    */
+    void done() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            --working_;
+        }
+        cv_.notify_all();
+    }
+
+    /*
+    called by render thread.
+    */
+    void waitDone() noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (working_ > 0 && unblocked_ == false) {
+            cv_.wait(lock);
+        }
+    }
+
+    virtual void unblock() noexcept {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            unblocked_ = true;
+        }
+        cv_.notify_all();
+    }
+};
+
+namespace {
+    class SirdsWorker : public agm::Thread {
+    public:
+        SirdsWorker(
+            SirdsFrame *frame
+        ) noexcept :
+            agm::Thread("SirdsWorker"),
+            frame_(frame) {
+            line_.init(frame->width_);
+        }
+
+        virtual ~SirdsWorker() = default;
+
+        SirdsFrame *frame_;
+        Scanline line_;
+        int generation_ = 0;
+
+        virtual void runOnce() noexcept {
+            auto good = frame_->wait(generation_);
+            if (good == false) {
+                return;
+            }
+            frame_->runRows(line_);
+            frame_->done();
+        }
+    };
+}
+
+Sirds::Sirds() noexcept {
+}
+
+Sirds::~Sirds() noexcept {
+    exit();
+}
+
+void Sirds::init(
+    int width,
+    int height
+) noexcept {
+    exit();
+
+    // the render thread is a worker too.
+    int nworkers = int(std::thread::hardware_concurrency()) - 1;
+    nworkers = std::max(0, std::min(nworkers, kMaxWorkers));
+
+    frame_ = new(std::nothrow) SirdsFrame(width, height);
+    containers_.push_back(frame_);
+    for (int i = 0; i < nworkers; ++i) {
+        threads_.push_back(new(std::nothrow) SirdsWorker(frame_));
+    }
+    agm::Thread::startAll(threads_, containers_);
+    LOG("width=" << width << " height=" << height << " workers=" << nworkers
+        << " eye=" << frame_->line_.eye_);
+}
+
+void Sirds::generate(
+    const std::uint8_t *depth,
+    std::uint8_t *rgb
+) noexcept {
+    if (frame_ == nullptr) {
+        return;
+    }
+    frame_->post(depth, rgb, threads_.size());
+    frame_->runRows(frame_->line_);
+    frame_->waitDone();
+}
+
+void Sirds::exit() noexcept {
+    if (frame_ == nullptr) {
+        return;
+    }
+
+    // deletes the frame.
+    agm::Thread::stopAll(threads_, containers_);
+    threads_.clear();
+    containers_.clear();
+    frame_ = nullptr;
+}
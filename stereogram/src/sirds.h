@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2012-2020 tim cotter. All rights reserved.
+*/
+
+#pragma once
+
+/**
+single image random dot stereogram.
+
+thimbleby, inglis, and witten.
+displaying 3d images: algorithms for single image random dot stereograms.
+ieee computer 1994.
+
+each scanline is independent.
+a pixel at depth z is seen by the left eye at x - s/2 and
+by the right eye at x + s/2.
+so those two pixels must be the same color.
+the constraints are linked into chains.
+the chains are colored right to left with random dots.
+
+there is no hidden surface removal.
+the sphere is convex so the only artifacts are at its rim.
+and it's too slow for 60 fps.
+
+the rows are split among a pool of worker threads.
+the render thread does its share of rows too.
+**/
+
+#include <cstdint>
+#include <vector>
+
+
+namespace agm {
+    class Container;
+    class Thread;
+}
+class SirdsFrame;
+
+class Sirds {
+public:
+    Sirds() noexcept;
+    Sirds(const Sirds &) = delete;
+    ~Sirds() noexcept;
+
+    // starts the workers.
+    void init(int width, int height) noexcept;
+
+    // depth is rgba rows. red is the depth. 0 is far. 255 is near.
+    // rgb is tightly packed rows.
+    void generate(const std::uint8_t *depth, std::uint8_t *rgb) noexcept;
+
+    // stops the workers.
+    void exit() noexcept;
+
+private:
+    SirdsFrame *frame_ = nullptr;
+    std::vector<agm::Thread *> threads_;
+    std::vector<agm::Container *> containers_;
+};
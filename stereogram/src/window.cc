@@ -27,15 +27,30 @@ namespace {
 
         Render *render_ = nullptr;
 
-        virtual void init() noexcept {
+        virtual void init(
+            bool headless,
+            const char *capture,
+            bool stats,
+            bool overlay,
+            bool sirds
+        ) noexcept {
             render_ = Render::create();
+            render_->setSirds(sirds);
+            if (capture) {
+                render_->setCapture(capture);
+            }
+            if (stats) {
+                render_->setStats(overlay);
+            }
+            simpleWindowSetHeadless(headless);
             simpleWindowInit(kWindowTitle, kWindowWidth, kWindowHeight);
             render_->init(kWindowWidth, kWindowHeight);
         }
 
         virtual void exit() noexcept {
-            simpleWindowExit();
+            // the renderer needs the gl context.
             render_->exit();
+            simpleWindowExit();
             delete render_;
         }
 
@@ -16,7 +16,7 @@ public:
     static StereoWindow *create() noexcept;
     virtual ~StereoWindow() noexcept;
 
-    virtual void init() noexcept = 0;
+    virtual void init(bool headless, const char *capture, bool stats, bool overlay, bool sirds) noexcept = 0;
     virtual void exit() noexcept = 0;
     virtual void run() noexcept = 0;
 };
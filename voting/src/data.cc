@@ -0,0 +1,33 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+the compiled in data sets by name.
+**/
+
+#include "data.h"
+
+const DataSet g_data_sets[] = {
+    {"burlington_2006", burlington_2006::get_voting_data, burlington_2006::get_candidates},
+    {"burlington_2009", burlington_2009::get_voting_data, burlington_2009::get_candidates},
+    {"minneapolis_park_1", minneapolis_park_1::get_voting_data, minneapolis_park_1::get_candidates},
+    {"minneapolis_park_3", minneapolis_park_3::get_voting_data, minneapolis_park_3::get_candidates},
+    {"minneapolis_park_5", minneapolis_park_5::get_voting_data, minneapolis_park_5::get_candidates},
+    {"minneapolis_park_6", minneapolis_park_6::get_voting_data, minneapolis_park_6::get_candidates},
+    {"minneapolis_ward_1", minneapolis_ward_1::get_voting_data, minneapolis_ward_1::get_candidates},
+    {"minneapolis_ward_3", minneapolis_ward_3::get_voting_data, minneapolis_ward_3::get_candidates},
+    {"minneapolis_ward_4", minneapolis_ward_4::get_voting_data, minneapolis_ward_4::get_candidates},
+    {"minneapolis_ward_5", minneapolis_ward_5::get_voting_data, minneapolis_ward_5::get_candidates},
+    {"minneapolis_ward_6", minneapolis_ward_6::get_voting_data, minneapolis_ward_6::get_candidates},
+    {"minneapolis_ward_7", minneapolis_ward_7::get_voting_data, minneapolis_ward_7::get_candidates},
+    {"minneapolis_ward_8", minneapolis_ward_8::get_voting_data, minneapolis_ward_8::get_candidates},
+    {"minneapolis_ward_9", minneapolis_ward_9::get_voting_data, minneapolis_ward_9::get_candidates},
+    {"minneapolis_ward_10", minneapolis_ward_10::get_voting_data, minneapolis_ward_10::get_candidates},
+    {"minneapolis_ward_11", minneapolis_ward_11::get_voting_data, minneapolis_ward_11::get_candidates},
+    {"minneapolis_ward_12", minneapolis_ward_12::get_voting_data, minneapolis_ward_12::get_candidates},
+    {"synthetic_1", synthetic_1::get_voting_data, synthetic_1::get_candidates},
+    {"synthetic_2", synthetic_2::get_voting_data, synthetic_2::get_candidates},
+    {"synthetic_3", synthetic_3::get_voting_data, synthetic_3::get_candidates},
+    {nullptr, nullptr, nullptr}
+};
@@ -15,6 +15,16 @@ public:
 };
 using Ballots = std::vector<Ballot>;
 
+/** the compiled in data sets by name. **/
+class DataSet {
+public:
+    const char *name_;
+    Ballots (*get_voting_data_)() noexcept;
+    Candidates (*get_candidates_)() noexcept;
+};
+/** terminated by a null name. **/
+extern const DataSet g_data_sets[];
+
 namespace burlington_2006 {
 Ballots get_voting_data() noexcept;
 Candidates get_candidates() noexcept;
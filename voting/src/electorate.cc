@@ -31,6 +31,25 @@ how many clusters? how much spread? to be determined.
 #include <iomanip>
 
 
+/**
+==experimental==
+non-linear utility.
+
+hack the distance to be more of a utility distance.
+near 0.0 is even nearer 1.0.
+at a threshold value the utility equals the 1.0 - distance.
+over the threshold asymptotically approaches 0.0.
+a threshold of about 0.3 t0 0.4 feels about right.
+the exponent factor would be 3.2 to 4.0.
+**/
+constexpr bool kNonLinearUtility = false;
+//constexpr bool kNonLinearUtility = true;
+constexpr double kScaleFactor = 3.9;
+
+/** voters per tile of the utility kernel. **/
+constexpr int kTileVoters = 256;
+
+
 class Cluster {
 public:
     /** size **/
@@ -66,25 +85,13 @@ double Position::utility(
     }
     double dist = std::sqrt(sum2);
 
+    if (kNonLinearUtility) {
+        double utility = std::exp(- kScaleFactor * dist * dist);
+        return utility;
+    }
+
     /** the simplest model for utility is 1.0 - distance. **/
     double utility = 1.0 - dist;
-
-    /**
-    ==experimental==
-    non-linear utility.
-
-    hack the distance to be more of a utility distance.
-    near 0.0 is even nearer 1.0.
-    at a threshold value the utility equals the 1.0 - distance.
-    over the threshold asymptotically approaches 0.0.
-    a threshold of about 0.3 t0 0.4 feels about right.
-    the exponent factor would be 3.2 to 4.0.
-    **/
-#if 0
-    constexpr double kScaleFactor = 3.9;
-    double utility = std::exp(- kScaleFactor * dist * dist);
-#endif
-
     return utility;
 }
 
@@ -113,12 +120,16 @@ bool Position::operator < (const Position& other) const
     return (axis_[0] < other.axis_[0]);
 }
 
-void Electorate::init() noexcept {
-    /** allocate space for the voters and candidates **/
-    voters_.resize(nvoters_);
+void Electorate::init(
+    Rng& rng
+) noexcept {
+    rng_ = &rng;
 
-    /** allocate space for the positions. **/
-    size_position_axes();
+    /** allocate space for the voters. **/
+    axes_.resize(naxes_);
+    for (auto&& axis : axes_) {
+        axis.resize(nvoters_);
+    }
 
     /** distribute the voter by the chosen method. **/
     switch (method_) {
@@ -142,24 +153,19 @@ void Electorate::init() noexcept {
     }
 }
 
-/** allocate space for the voter positions. **/
-void Electorate::size_position_axes() noexcept {
-    for (auto&& voter : voters_) {
-        voter.position_.axis_.resize(naxes_);
-    }
-}
-
 /**
 evenly distribute voters from 0 to 1 along a single axis.
 this is the simplest model of the electorate.
 **/
 void Electorate::ranked() noexcept {
-    LOG("Electorate is uniform ranked order.");
+    if (quiet_ == false) {
+        LOG("Electorate is uniform ranked order.");
+    }
     double nvoters = double(nvoters_);
     double offset = 0.5 / nvoters;
+    auto& axis = axes_[0];
     for (int i = 0; i < nvoters_; ++i) {
-        auto& axis = voters_[i].position_.axis_;
-        axis[0] = offset + double(i) / nvoters;
+        axis[i] = offset + double(i) / nvoters;
     }
 }
 
@@ -167,11 +173,16 @@ void Electorate::ranked() noexcept {
 randomly distribute voters along the axes.
 **/
 void Electorate::random() noexcept {
-    LOG("Electorate is random.");
-    for (int i = 0; i < nvoters_; ++i) {
-        auto& axis = voters_[i].position_.axis_;
-        for (int k = 0; k < naxes_; ++k) {
-            axis[k] = Rng::generate();
+    if (quiet_ == false) {
+        LOG("Electorate is random.");
+    }
+    /** same order as one voter at a time. **/
+    std::vector<double> values(nvoters_ * naxes_);
+    rng_->generate(values.data(), values.size());
+    for (int k = 0; k < naxes_; ++k) {
+        auto& axis = axes_[k];
+        for (int i = 0; i < nvoters_; ++i) {
+            axis[i] = values[i * naxes_ + k];
         }
     }
 }
@@ -180,7 +191,9 @@ void Electorate::random() noexcept {
 chinese restaurant process.
 **/
 void Electorate::clusters() noexcept {
-    LOG("Electorate is clustered.");
+    if (quiet_ == false) {
+        LOG("Electorate is clustered.");
+    }
 
     /** create empty clusters. **/
     Clusters clusters;
@@ -190,13 +203,17 @@ void Electorate::clusters() noexcept {
         cluster.position_.axis_.reserve(naxes_);
         cluster.position_.axis_.resize(naxes_);
         for (int i = 0; i < naxes_; ++i) {
-            cluster.position_.axis_[i] = Rng::generate();
+            cluster.position_.axis_[i] = rng_->generate();
         }
     }
     std::sort(clusters.begin(), clusters.end());
 
+    /** all the offsets from the clusters at once. **/
+    std::vector<double> offsets(nvoters_ * naxes_);
+    rng_->normal(offsets.data(), offsets.size());
+
     for (int i = 0; i < nvoters_; ++i) {
-        seat_voter(clusters, i);
+        seat_voter(clusters, i, &offsets[i * naxes_]);
     }
 }
 
@@ -211,7 +228,8 @@ maybe 2 times number of candidates.
 **/
 void Electorate::seat_voter(
     Clusters& clusters,
-    int k
+    int k,
+    const double *offsets
 ) noexcept {
     /**
     what should the standard deviation be?
@@ -228,7 +246,7 @@ void Electorate::seat_voter(
         where = k;
     } else {
         /** populare clusters attract more people. **/
-        int rn = Rng::generate(k);
+        int rn = rng_->generate(k);
         for (auto&& cluster : clusters) {
             rn -= cluster.count_;
             if (rn < 0) {
@@ -246,11 +264,10 @@ void Electorate::seat_voter(
     cluster.count_ += 1;
 
     /** position the voter. **/
-    auto& voter = voters_[k];
     for (int i = 0; i < naxes_; ++i) {
-        double rn = Rng::normal() * kStdDev;
+        double rn = offsets[i] * kStdDev;
         double position = cluster.position_.axis_[i] + rn;
-        voter.position_.axis_[i] = position;
+        axes_[i][k] = position;
     }
 }
 
@@ -272,20 +289,19 @@ void Electorate::normalize(
     int axis,
     double weight
 ) noexcept {
+    auto& positions = axes_[axis];
     double mn = 1e99;
     double mx = -1e99;
-    for (auto&& voter : voters_) {
-        mn = std::min(mn, voter.position_.axis_[axis]);
-        mx = std::max(mx, voter.position_.axis_[axis]);
+    for (auto pos : positions) {
+        mn = std::min(mn, pos);
+        mx = std::max(mx, pos);
     }
 
     double scale = weight / (mx - mn);
-    for (auto&& voter : voters_) {
-        double pos = voter.position_.axis_[axis];
+    for (auto&& pos : positions) {
         pos -= mn;
         pos *= scale;
         pos = std::clamp(pos, 0.0, 1.0);
-        voter.position_.axis_[axis] = pos;
     }
 }
 
@@ -314,16 +330,113 @@ void Electorate::show_distribution(
     for (int i = 0; i < kNBins; ++i) {
         bins[i] = 0;
     }
-    for (auto&& voter : voters_) {
-        double position = voter.position_.axis_[axis];
+    for (auto position : axes_[axis]) {
         int i = std::floor(position * kNBins);
         i = std::clamp(i, 0, kNBins - 1);
         ++bins[i];
     }
-    double nvoters = voters_.size();
+    double nvoters = nvoters_;
     for (int i = 0; i < kNBins; ++i) {
         double mx = double(i+1) / kNBins;
         double frac = 100.0 * double(bins[i]) / nvoters;
         LOG("  "<<mx<<": "<<bins[i]<<" "<<frac<<"%");
     }
 }
+
+Position Electorate::get_position(
+    int voter
+) const noexcept {
+    Position position;
+    position.axis_.resize(naxes_);
+    for (int i = 0; i < naxes_; ++i) {
+        position.axis_[i] = axes_[i][voter];
+    }
+    return position;
+}
+
+/**
+a tile of voters against one position at a time.
+the inner loops run down the contiguous axes.
+so they vectorize.
+the sums are in axis order like Position::utility.
+so the results are the same.
+**/
+void Electorate::get_utilities(
+    const std::vector<Position>& positions,
+    std::vector<double>& utilities
+) const noexcept {
+    int npositions = positions.size();
+    utilities.resize(std::size_t(nvoters_) * npositions);
+    for (int first = 0; first < nvoters_; first += kTileVoters) {
+        int count = std::min(kTileVoters, nvoters_ - first);
+        auto row = &utilities[std::size_t(first) * npositions];
+        for (int c = 0; c < npositions; ++c) {
+            get_tile_utilities(positions[c], first, count, row + c, npositions);
+        }
+    }
+}
+
+/**
+same tiles as get_utilities.
+each tile is summed while it's in the cache.
+**/
+void Electorate::get_utility_sums(
+    const std::vector<Position>& positions,
+    std::vector<double>& sums
+) const noexcept {
+    int npositions = positions.size();
+    sums.assign(npositions, 0.0);
+    double tile[kTileVoters];
+    for (int first = 0; first < nvoters_; first += kTileVoters) {
+        int count = std::min(kTileVoters, nvoters_ - first);
+        for (int c = 0; c < npositions; ++c) {
+            get_tile_utilities(positions[c], first, count, tile, 1);
+            double sum = sums[c];
+            for (int i = 0; i < count; ++i) {
+                sum += tile[i];
+            }
+            sums[c] = sum;
+        }
+    }
+}
+
+void Electorate::get_tile_utilities(
+    const Position& position,
+    int first,
+    int count,
+    double *out,
+    int stride
+) const noexcept {
+    auto& axis = position.axis_;
+    if (naxes_ == 1) {
+        auto x = &axes_[0][first];
+        double p = axis[0];
+        for (int i = 0; i < count; ++i) {
+            out[std::size_t(i) * stride] = 1.0 - std::abs(x[i] - p);
+        }
+        return;
+    }
+
+    double sum2[kTileVoters];
+    for (int i = 0; i < count; ++i) {
+        sum2[i] = 0.0;
+    }
+    for (int k = 0; k < naxes_; ++k) {
+        auto x = &axes_[k][first];
+        double p = axis[k];
+        for (int i = 0; i < count; ++i) {
+            double dx = x[i] - p;
+            sum2[i] += dx * dx;
+        }
+    }
+    if (kNonLinearUtility) {
+        for (int i = 0; i < count; ++i) {
+            double dist = std::sqrt(sum2[i]);
+            out[std::size_t(i) * stride] = std::exp(- kScaleFactor * dist * dist);
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            out[std::size_t(i) * stride] = 1.0 - std::sqrt(sum2[i]);
+        }
+    }
+}
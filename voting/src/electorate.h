@@ -4,10 +4,16 @@ Copyright (C) 2012-2025 tim cotter. All rights reserved.
 
 /**
 model the electorate.
+
+the voters are stored as a structure of arrays.
+one contiguous array per axis.
+the utility kernel streams through them a tile of voters at a time.
 **/
 
 #pragma once
 
+#include "random.h"
+
 #include <string>
 #include <vector>
 
@@ -35,16 +41,6 @@ public:
     bool operator < (const Position& other) const;
 };
 
-class Voter {
-public:
-    Voter() = default;
-    ~Voter() = default;
-
-    /** position along the axis ranges from 0..1 **/
-    Position position_;
-};
-typedef std::vector<Voter> Voters;
-
 class Cluster;
 typedef std::vector<Cluster> Clusters;
 
@@ -60,24 +56,54 @@ public:
     /** minor axes have reduced range (and utility). **/
     double axis_weight_decay_ = 1.0;
     int nclusters_ = 6;
-
-    /** data **/
-    Voters voters_;
-
-    /** set configuration parameters above. required. **/
-    void init() noexcept;
+    /** don't log the distribution method. **/
+    bool quiet_ = false;
+
+    /**
+    data.
+    position along the axis ranges from 0..1
+    voter i is at axes_[0][i], axes_[1][i], ...
+    **/
+    std::vector<std::vector<double>> axes_;
+
+    /**
+    set configuration parameters above. required.
+    the voters are placed with the random number generator.
+    **/
+    void init(Rng& rng) noexcept;
 
     /** what did we get. **/
     void show_distribution() noexcept;
 
+    /** the position of one voter. **/
+    Position get_position(int voter) const noexcept;
+
+    /**
+    the utility of every position to every voter.
+    same as Position::utility.
+    utilities[voter * positions.size() + i]
+    **/
+    void get_utilities(const std::vector<Position>& positions, std::vector<double>& utilities) const noexcept;
+
+    /**
+    the sum over all voters of the utility of every position.
+    summed in voter order.
+    same as adding up the rows of get_utilities without storing them.
+    **/
+    void get_utility_sums(const std::vector<Position>& positions, std::vector<double>& sums) const noexcept;
+
     /** private implementation. **/
 private:
-    void size_position_axes() noexcept;
+    Rng *rng_ = nullptr;
+
     void ranked() noexcept;
     void random() noexcept;
     void clusters() noexcept;
-    void seat_voter(Clusters &clusters, int k) noexcept;
+    /** offsets are normals. one per axis. **/
+    void seat_voter(Clusters &clusters, int k, const double *offsets) noexcept;
     void normalize() noexcept;
     void normalize(int axis, double weight) noexcept;
     void show_distribution(int axis) noexcept;
+    /** one position to count voters starting at first. out is strided. **/
+    void get_tile_utilities(const Position& position, int first, int count, double *out, int stride) const noexcept;
 };
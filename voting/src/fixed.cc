@@ -66,11 +66,22 @@ apparently this system is quite sensitive to ranking of irrelevant alternates.
 
 #include "data.h"
 #include "fixed.h"
+#include "kemeny.h"
+#include "log_details.h"
+#include "packed.h"
+#include "pairwise.h"
+#include "parallel.h"
+#include "store.h"
+#include "tally.h"
 
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <numeric>
 
 /** choose a data set. **/
 //using namespace burlington_2006;
@@ -104,10 +115,28 @@ class Result {
 public:
     std::string who_;
     int idx_ = 0;
-    int count_ = 0;
+    /** reverse rank order scales the counts. **/
+    std::int64_t count_ = 0;
 };
 using Results = std::vector<Result>;
 
+/** one row of the consolidated table. **/
+class Summary {
+public:
+    std::string name_;
+    int nballots_ = 0;
+    int nunique_ = 0;
+    int ncandidates_ = 0;
+    std::string first_past_post_;
+    std::string head_to_head_;
+    std::string ranked_choice_;
+    int ranked_choice_rounds_ = 0;
+    std::string reverse_rank_order_;
+    int reverse_rank_order_rounds_ = 0;
+    double ms_ = 0.0;
+};
+using Summaries = std::vector<Summary>;
+
 class VotingImpl {
 public:
     VotingImpl() = default;
@@ -117,35 +146,84 @@ public:
 
     int nballots_ = 0;
     int ncandidates_ = 0;
-    Ballots ballots_;
+    /**
+    identical ballots are collapsed. see PackedBallot.
+    the methods never change the ballots. see RankedTally.
+    **/
+    PackedBallots ballots_;
     Candidates candidates_;
     Results results_;
+    /** candidate i+1 is row i. **/
+    PairwiseMatrix pairwise_;
+    bool quiet_ = false;
+    Summary summary_;
 
     void run() noexcept {
-        restore_ballots();
+        ballots_ = pack_ballots(get_voting_data());
         candidates_ = get_candidates();
-        nballots_ = ballots_.size();
+        run_methods();
+    }
+
+    void run_data_set(
+        const DataSet& data_set
+    ) noexcept {
+        summary_.name_ = data_set.name_;
+        ballots_ = pack_ballots(data_set.get_voting_data_());
+        candidates_ = data_set.get_candidates_();
+        run_methods();
+    }
+
+    bool run_file(
+        const char *filename
+    ) noexcept {
+        BallotStore store;
+        auto good = store.load(filename);
+        if (good == false) {
+            return false;
+        }
+        ballots_ = store.get_packed_ballots();
+        candidates_ = store.get_candidates();
+        run_methods();
+        return true;
+    }
+
+    void run_methods() noexcept {
+        auto start = std::chrono::steady_clock::now();
+        nballots_ = count_ballots(ballots_);
         ncandidates_ = candidates_.size();
         results_.resize(ncandidates_);
+        summary_.nballots_ = nballots_;
+        summary_.nunique_ = ballots_.size();
+        summary_.ncandidates_ = ncandidates_ - 1;
+
+        LOG_DETAILS("");
+        LOG_DETAILS("ballots.size()="<<nballots_);
+        LOG_DETAILS("unique ballots="<<ballots_.size());
+        LOG_DETAILS("candidates_.size()="<<ncandidates_);
 
-        LOG("");
-        LOG("ballots.size()="<<nballots_);
-        LOG("candidates_.size()="<<ncandidates_);
+        build_pairwise();
 
-        show_candidates();
-        show_stats();
+        if (quiet_ == false) {
+            show_candidates();
+            show_stats();
+        }
         first_past_post();
         head_to_head();
         //head_to_head_elimination();
+        schulze();
+        ranked_pairs();
+        kemeny_young();
         ranked_choice_voting();
         reverse_rank_order();
 
-        LOG("");
+        LOG_DETAILS("");
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        summary_.ms_ = std::chrono::duration<double, std::milli>(elapsed).count();
     }
 
     void show_candidates() noexcept {
-        LOG("");
-        LOG("Candidates:");
+        LOG_DETAILS("");
+        LOG_DETAILS("Candidates:");
         init_results();
         for (int i = 1; i < ncandidates_; ++i) {
             results_[i].count_ = i;
@@ -154,15 +232,14 @@ public:
     }
 
     void show_stats() noexcept {
-        LOG("");
-        LOG("Statistics:");
-        restore_ballots();
+        LOG_DETAILS("");
+        LOG_DETAILS("Statistics:");
         std::vector<int> counts(ncandidates_, 0);
         for (auto&& ballot : ballots_) {
             for (int i = 0; i < ncandidates_ - 1; ++i) {
-                int choice = ballot.choice_[i];
+                int choice = ballot.choice(i);
                 if (choice > 0) {
-                    ++counts[i];
+                    counts[i] += ballot.count_;
                 }
             }
         }
@@ -172,98 +249,59 @@ public:
         for (int i = 0; i < ncandidates_ - 1; ++i) {
             double pct = double(counts[i]) / double(nballots_);
             pct = int(pct * 10000.0) / 100.0;
-            LOG(pct<<"% voted for "<<i+1<<" candidates.");
+            LOG_DETAILS(pct<<"% voted for "<<i+1<<" candidates.");
         }
     }
 
     void first_past_post() noexcept {
-        restore_ballots();
         init_results();
-        for (auto ballot : ballots_) {
-            int choice = ballot.choice_[0];
+        for (auto&& ballot : ballots_) {
+            int choice = ballot.choice(0);
             auto& result = results_[choice];
-            ++result.count_;
+            result.count_ += ballot.count_;
         }
         sort_results();
-        LOG("");
-        LOG("First Past the Post Results:");
+        LOG_DETAILS("");
+        LOG_DETAILS("First Past the Post Results:");
         print_results();
         auto& winner = results_[1];
-        LOG("Winner: "<<winner.who_);
+        LOG_DETAILS("Winner: "<<winner.who_);
+        summary_.first_past_post_ = winner.who_;
     }
 
     void head_to_head() noexcept {
-        LOG("");
-        LOG("Head to Head Results:");
-        restore_ballots();
+        LOG_DETAILS("");
+        LOG_DETAILS("Head to Head Results:");
         init_results();
-        auto rankings = ballots_;
-        for (int i = 0; i < nballots_; ++i) {
-            auto& src = ballots_[i];
-            auto& dst = rankings[i];
-            for (int k = 0; k < ncandidates_-1; ++k) {
-                dst.choice_[k] = ncandidates_;
-            }
-            for (int k = 0; k < ncandidates_-1; ++k) {
-                int choice = src.choice_[k];
-                if (choice > 0) {
-                    dst.choice_[choice-1] = k+1;
-                }
-            }
-        }
         int max_wins = 0;
         int winner = 0;
         for (int i = 0; i < ncandidates_-1; ++i) {
             int wins = 0;
             for (int k = 0; k < ncandidates_-1; ++k) {
-                int fori = 0;
-                int fork = 0;
-                for (auto&& ranking : rankings) {
-                    int ranki = ranking.choice_[i];
-                    int rankk = ranking.choice_[k];
-                    if (ranki < rankk) {
-                        ++fori;
-                    }
-                    if (rankk < ranki) {
-                        ++fork;
-                    }
-                }
+                int fori = pairwise_.votes(i, k);
+                int fork = pairwise_.votes(k, i);
                 if (fori > fork) {
-                    LOG(candidates_[i+1]<<" beat "<<candidates_[k+1]<<" "<<fori<<" to "<<fork<<".");
+                    LOG_DETAILS(candidates_[i+1]<<" beat "<<candidates_[k+1]<<" "<<fori<<" to "<<fork<<".");
                     ++wins;
                 }
             }
             int losses = ncandidates_ - 2 - wins;
-            LOG(candidates_[i+1]<<" has "<<wins<<" wins and "<<losses<<" losses.");
+            LOG_DETAILS(candidates_[i+1]<<" has "<<wins<<" wins and "<<losses<<" losses.");
             if (max_wins < wins) {
                 max_wins = wins;
                 winner = i + 1;
             }
         }
-        LOG("Winner: "<<candidates_[winner]);
+        LOG_DETAILS("Winner: "<<candidates_[winner]);
+        summary_.head_to_head_ = candidates_[winner];
     }
 
     void head_to_head_elimination() noexcept {
-        LOG("");
-        LOG("Head to Head Elimination Results:");
-        restore_ballots();
+        LOG_DETAILS("");
+        LOG_DETAILS("Head to Head Elimination Results:");
         init_results();
         std::vector<int> in_race(ncandidates_, 1);
         for (int round = 1; round < ncandidates_-1; ++round) {
-            auto rankings = ballots_;
-            for (int i = 0; i < nballots_; ++i) {
-                auto& src = ballots_[i];
-                auto& dst = rankings[i];
-                for (int k = 0; k < ncandidates_-1; ++k) {
-                    dst.choice_[k] = ncandidates_;
-                }
-                for (int k = 0; k < ncandidates_-1; ++k) {
-                    int choice = src.choice_[k];
-                    if (choice > 0) {
-                        dst.choice_[choice-1] = k+1;
-                    }
-                }
-            }
             int min_wins = ncandidates_;
             int loser = 0;
             for (int i = 0; i < ncandidates_-1; ++i) {
@@ -275,31 +313,18 @@ public:
                     if (in_race[k] == 0) {
                         continue;
                     }
-                    int fori = 0;
-                    int fork = 0;
-                    for (auto&& ranking : rankings) {
-                        int ranki = ranking.choice_[i];
-                        int rankk = ranking.choice_[k];
-                        if (ranki < rankk) {
-                            ++fori;
-                        }
-                        if (rankk < ranki) {
-                            ++fork;
-                        }
-                    }
-                    if (fori > fork) {
-                        //LOG(i+1<<" beat "<<k+1<<" "<<fori<<" to "<<fork);
+                    if (pairwise_.beats(i, k)) {
+                        //LOG_DETAILS(i+1<<" beat "<<k+1<<" "<<pairwise_.votes(i, k)<<" to "<<pairwise_.votes(k, i));
                         ++wins;
                     }
                 }
-                //LOG(i+1<<" has "<<wins<<" wins");
+                //LOG_DETAILS(i+1<<" has "<<wins<<" wins");
                 if (min_wins > wins) {
                     min_wins = wins;
                     loser = i;
                 }
             }
-            LOG(candidates_[loser+1]<<" is eliminated.");
-            eliminate_from_ballots(loser+1);
+            LOG_DETAILS(candidates_[loser+1]<<" is eliminated.");
             in_race[loser] = 0;
         }
         int winner = -1;
@@ -309,60 +334,116 @@ public:
                 break;
             }
         }
-        LOG("Winner: "<<candidates_[winner]);
+        LOG_DETAILS("Winner: "<<candidates_[winner]);
+    }
+
+    void schulze() noexcept {
+        LOG_DETAILS("");
+        LOG_DETAILS("Schulze Results:");
+        int winner = pairwise_.schulze_winner();
+        LOG_DETAILS("Winner: "<<candidates_[winner+1]);
+    }
+
+    void ranked_pairs() noexcept {
+        LOG_DETAILS("");
+        LOG_DETAILS("Ranked Pairs Results:");
+        int winner = pairwise_.ranked_pairs_winner();
+        LOG_DETAILS("Winner: "<<candidates_[winner+1]);
+    }
+
+    void kemeny_young() noexcept {
+        LOG_DETAILS("");
+        LOG_DETAILS("Kemeny-Young Results:");
+        KemenyYoung kemeny;
+        kemeny.solve(pairwise_);
+        init_results();
+        for (int i = 0; i < ncandidates_-1; ++i) {
+            auto& result = results_[i+1];
+            int which = kemeny.ranking_[i] + 1;
+            result.who_ = candidates_[which];
+            result.idx_ = which;
+            result.count_ = i + 1;
+        }
+        print_results();
+        LOG_DETAILS("Agrees with "<<kemeny.score_<<" voter preferences. Solved in "<<kemeny.ms_<<" ms.");
+        LOG_DETAILS("Winner: "<<results_[1].who_);
     }
 
     void ranked_choice_voting() noexcept {
-        LOG("");
-        LOG("Ranked Choice Results:");
-        restore_ballots();
-        std::vector<int> in_race(ncandidates_, 1);
+        LOG_DETAILS("");
+        LOG_DETAILS("Ranked Choice Results:");
+        RankedTally tally;
+        tally.init(ballots_, ncandidates_);
         for (int rank = ncandidates_ - 2; rank > 0; --rank) {
             init_results();
-            for (auto&& ballot : ballots_) {
-                int choice = ballot.choice_[0];
-                if (choice > 0) {
-                    /** first place vote for one candidate. **/
-                    auto& result = results_[choice];
-                    ++result.count_;
-                }
+            for (int i = 1; i < ncandidates_; ++i) {
+                /** first place votes. **/
+                results_[i].count_ = tally.count(i);
             }
             sort_results();
 #if EXTRA_LOGGING
-            LOG("Rank: "<<rank);
+            LOG_DETAILS("Rank: "<<rank);
             print_results();
 #endif
             auto& loser = results_[rank+1];
-            LOG(loser.who_<<" is eliminated.");
-            eliminate_from_ballots(loser.idx_);
-            in_race[loser.idx_] = 0;
+            LOG_DETAILS(loser.who_<<" is eliminated.");
+            tally.eliminate(loser.idx_);
+            ++summary_.ranked_choice_rounds_;
         }
         auto& winner = results_[1];
-        LOG("Winner: "<<winner.who_);
+        LOG_DETAILS("Winner: "<<winner.who_);
+        summary_.ranked_choice_ = winner.who_;
     }
 
     void reverse_rank_order() noexcept {
-        LOG("");
-        LOG("Reverse Rank Order Results:");
-        restore_ballots();
+        LOG_DETAILS("");
+        LOG_DETAILS("Reverse Rank Order Results:");
+        /**
+        the last place vote depends on the rank.
+        so every ballot is counted every round.
+        but the ballots are never rewritten.
+
+        the counts are scaled by the lcm of the number of candidates.
+        so split last place votes are whole numbers.
+        the scaled counts have to fit in 64 bits.
+        **/
+        std::int64_t lcm_max = get_lcm(ncandidates_ - 1);
+        if (lcm_max == 0) {
+            LOG("Reverse rank order can't scale the counts for "<<ncandidates_ - 1<<" candidates in 64 bits.");
+            summary_.reverse_rank_order_ = "-";
+            return;
+        }
+        if (nballots_ > 0 && lcm_max > INT64_MAX / nballots_) {
+            LOG("Reverse rank order can't count "<<nballots_<<" ballots for "
+                <<ncandidates_ - 1<<" candidates in 64 bits.");
+            summary_.reverse_rank_order_ = "-";
+            return;
+        }
+
+        RankedTally tally;
+        tally.init(ballots_, ncandidates_);
+        int choices[PackedBallot::kMaxChoices + 1];
         std::vector<int> in_race(ncandidates_, 1);
         for (int rank = ncandidates_ - 2; rank > 0; --rank) {
             init_results();
-            int lcm = get_lcm(rank+1);
-            for (auto&& ballot : ballots_) {
-                int choice = ballot.choice_[rank];
+            std::int64_t lcm = get_lcm(rank+1);
+            for (int b = 0, nunique = ballots_.size(); b < nunique; ++b) {
+                auto& ballot = ballots_[b];
+                tally.get_choices(b, choices);
+                choices[PackedBallot::kMaxChoices] = 0;
+                int choice = choices[std::min(rank, PackedBallot::kMaxChoices)];
                 if (choice > 0) {
                     /** last place vote for one candidate. **/
                     auto& result = results_[choice];
-                    result.count_ += lcm;
+                    result.count_ += lcm * ballot.count_;
                 } else {
                     /**
                     last place votes for many candidates.
                     divide the lcm evenly between them.
                     **/
                     auto is_last = in_race;
-                    for (int i = 0; i <= rank; ++i) {
-                        choice = ballot.choice_[i];
+                    for (int i = 0; i <= rank && i < PackedBallot::kMaxChoices; ++i) {
+                        choice = choices[i];
                         is_last[choice] = 0;
                     }
                     int nlasts = 0;
@@ -374,14 +455,14 @@ public:
                     for (int i = 1; i < ncandidates_; ++i) {
                         if (is_last[i]) {
                             auto& result = results_[i];
-                            result.count_ += lcm / nlasts;
+                            result.count_ += lcm / nlasts * ballot.count_;
                         }
                     }
                 }
             }
             sort_results();
 #if EXTRA_LOGGING
-            LOG("Rank: "<<rank);
+            LOG_DETAILS("Rank: "<<rank);
             for (int i = 1; i < ncandidates_; ++i) {
                 auto& result = results_[i];
                 result.count_ /= lcm;
@@ -389,50 +470,54 @@ public:
             print_results();
 #endif
             auto& loser = results_[1];
-            LOG(loser.who_<<" is eliminated.");
-            eliminate_from_ballots(loser.idx_);
+            LOG_DETAILS(loser.who_<<" is eliminated.");
+            tally.eliminate(loser.idx_);
             in_race[loser.idx_] = 0;
+            ++summary_.reverse_rank_order_rounds_;
         }
         auto& winner = results_[2];
-        LOG("Winner: "<<winner.who_);
+        LOG_DETAILS("Winner: "<<winner.who_);
+        summary_.reverse_rank_order_ = winner.who_;
     }
 
-    int get_lcm(int max) noexcept {
-        static int g_table[] = {
-            0, 1, 2,
-            2*3,
-            1*3*4,
-            1*3*4*5,
-            2*1*1*5*6,
-            2*1*1*5*6*7,
-            1*3*1*5*3*7*8
-        };
-        if (max < 0 || max > 8) {
-            max = 0;
+    /**
+    least common multiple of 1..max.
+    0 if it doesn't fit in 64 bits.
+    **/
+    std::int64_t get_lcm(int max) noexcept {
+        std::int64_t lcm = 1;
+        for (int i = 2; i <= max; ++i) {
+            std::int64_t gcd = std::gcd(lcm, std::int64_t(i));
+            std::int64_t factor = i / gcd;
+            if (lcm > INT64_MAX / factor) {
+                return 0;
+            }
+            lcm *= factor;
         }
-        int lcm = g_table[max];
         return lcm;
     }
 
-    void eliminate_from_ballots(
-        int loser_idx
-    ) noexcept {
-        int nchoices = ncandidates_ - 1;
-        for (auto&& ballot : ballots_) {
-            int dst = 0;
-            for (int src = 0; src < nchoices; ++src) {
-                if (ballot.choice_[src] != loser_idx) {
-                    ballot.choice_[dst++] = ballot.choice_[src];
+    /**
+    the rank of every candidate on every unique ballot.
+    unranked candidates are ranked last.
+    **/
+    void build_pairwise() noexcept {
+        int nranks = ncandidates_ - 1;
+        int nunique = ballots_.size();
+        std::vector<int> rankings(nunique * nranks, ncandidates_);
+        std::vector<int> weights(nunique);
+        for (int i = 0; i < nunique; ++i) {
+            auto& src = ballots_[i];
+            auto dst = &rankings[i * nranks];
+            for (int k = 0; k < nranks; ++k) {
+                int choice = src.choice(k);
+                if (choice > 0) {
+                    dst[choice-1] = k+1;
                 }
             }
-            for (; dst < nchoices; ++dst) {
-                ballot.choice_[dst] = 0;
-            }
+            weights[i] = src.count_;
         }
-    }
-
-    void restore_ballots() noexcept {
-        ballots_ = get_voting_data();
+        pairwise_.init(rankings, weights, nranks);
     }
 
     void init_results() noexcept {
@@ -457,7 +542,7 @@ public:
     void print_results() noexcept {
         for (int i = 1; i < ncandidates_; ++i) {
             auto& result = results_[i];
-            LOG(result.who_<<": "<<result.count_);
+            LOG_DETAILS(result.who_<<": "<<result.count_);
         }
     }
 
@@ -468,18 +553,61 @@ public:
     }
 
     void print_ballot(
-        const Ballot& ballot
+        const PackedBallot& ballot
     ) noexcept {
-        LOG("ballot={"
-            <<ballot.choice_[0]<<", "
-            <<ballot.choice_[1]<<", "
-            <<ballot.choice_[2]<<", "
-            <<ballot.choice_[3]<<", "
-            <<ballot.choice_[4]<<", "
-            <<ballot.choice_[5]<<"}");
+        LOG_DETAILS("ballot={"
+            <<ballot.choice(0)<<", "
+            <<ballot.choice(1)<<", "
+            <<ballot.choice(2)<<", "
+            <<ballot.choice(3)<<", "
+            <<ballot.choice(4)<<", "
+            <<ballot.choice(5)<<"} x"<<ballot.count_);
     }
 };
 
+void show_summaries(
+    const Summaries& summaries
+) noexcept {
+    /** fit the columns to the names. **/
+    int name_width = 8;
+    int winner_width = 6;
+    for (auto&& summary : summaries) {
+        name_width = std::max(name_width, int(summary.name_.size()));
+        winner_width = std::max(winner_width, int(summary.first_past_post_.size()));
+        winner_width = std::max(winner_width, int(summary.head_to_head_.size()));
+        winner_width = std::max(winner_width, int(summary.ranked_choice_.size()));
+        winner_width = std::max(winner_width, int(summary.reverse_rank_order_.size()));
+    }
+
+    LOG("");
+    LOG(std::left
+        <<std::setw(name_width)<<"Election"
+        <<" "<<std::right<<std::setw(8)<<"Ballots"
+        <<" "<<std::setw(7)<<"Unique"
+        <<" "<<std::setw(5)<<"Cands"
+        <<" "<<std::left<<std::setw(winner_width)<<"FPTP"
+        <<" "<<std::setw(winner_width)<<"H2H"
+        <<" "<<std::setw(winner_width)<<"RCV"
+        <<" "<<std::right<<std::setw(6)<<"Rounds"
+        <<" "<<std::left<<std::setw(winner_width)<<"RROV"
+        <<" "<<std::right<<std::setw(6)<<"Rounds"
+        <<" "<<std::setw(9)<<"ms");
+    for (auto&& s : summaries) {
+        LOG(std::left
+            <<std::setw(name_width)<<s.name_
+            <<" "<<std::right<<std::setw(8)<<s.nballots_
+            <<" "<<std::setw(7)<<s.nunique_
+            <<" "<<std::setw(5)<<s.ncandidates_
+            <<" "<<std::left<<std::setw(winner_width)<<s.first_past_post_
+            <<" "<<std::setw(winner_width)<<s.head_to_head_
+            <<" "<<std::setw(winner_width)<<s.ranked_choice_
+            <<" "<<std::right<<std::setw(6)<<s.ranked_choice_rounds_
+            <<" "<<std::left<<std::setw(winner_width)<<s.reverse_rank_order_
+            <<" "<<std::right<<std::setw(6)<<s.reverse_rank_order_rounds_
+            <<" "<<std::setw(9)<<std::fixed<<std::setprecision(3)<<s.ms_);
+    }
+}
+
 } // anonymous namespace
 
 FixedDataVoting::FixedDataVoting() noexcept {
@@ -495,3 +623,38 @@ void FixedDataVoting::run() noexcept {
     auto impl = (VotingImpl *) impl_;
     impl->run();
 }
+
+bool FixedDataVoting::run_file(
+    const char *filename
+) noexcept {
+    auto impl = (VotingImpl *) impl_;
+    return impl->run_file(filename);
+}
+
+void FixedDataVoting::run_all(
+    int nthreads
+) noexcept {
+    auto start = std::chrono::steady_clock::now();
+
+    int nelections = 0;
+    while (g_data_sets[nelections].name_) {
+        ++nelections;
+    }
+    Summaries summaries(nelections);
+
+    nthreads = parallel_threads(nthreads, nelections);
+    parallel_for(nthreads, nelections, [&summaries](int, int i) {
+        /** every election has its own ballots. **/
+        VotingImpl impl;
+        impl.quiet_ = true;
+        impl.run_data_set(g_data_sets[i]);
+        summaries[i] = std::move(impl.summary_);
+    });
+
+    show_summaries(summaries);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    LOG("");
+    LOG("Tabulated "<<nelections<<" elections on "<<nthreads<<" threads in "<<ms<<" ms.");
+}
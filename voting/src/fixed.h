@@ -13,8 +13,19 @@ public:
     FixedDataVoting() noexcept;
     ~FixedDataVoting() noexcept;
 
+    /** the data set chosen in fixed.cc. **/
     void run() noexcept;
 
+    /** a ballot file. see BallotStore. **/
+    bool run_file(const char *filename) noexcept;
+
+    /**
+    every registered data set on a pool of threads.
+    logs one table instead of the details.
+    nthreads 0 is one per core.
+    **/
+    void run_all(int nthreads) noexcept;
+
 private:
     void *impl_ = nullptr;
 };
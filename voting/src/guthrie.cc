@@ -204,15 +204,18 @@ non-linear utility or piece-wise linear utility,
 
 #include "electorate.h"
 #include "guthrie.h"
+#include "log_details.h"
+#include "pairwise.h"
+#include "parallel.h"
 #include "random.h"
 
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <iomanip>
-#include <map>
 #include <vector>
 
 
@@ -286,6 +289,15 @@ default compromise is about 0.4.
 **/
 constexpr double kPrimaryPower = 0.4;
 
+/**
+trials run on a pool of threads.
+0 is one per core up to kMaxParallelThreads.
+1 logs the details of every trial.
+the summary doesn't depend on the number of threads.
+**/
+constexpr int kNThreads = 0;
+//constexpr int kNThreads = 1;
+
 /** option to use a fixed seed for testing. **/
 constexpr std::uint64_t kSeedChoice = 0;
 //constexpr std::uint64_t kSeedChoice = 1749001466860975755;
@@ -335,6 +347,54 @@ public:
     double average_ = 0;
 };
 
+/** the criteria results summed over trials. **/
+class Totals {
+public:
+    double total_satisfaction_ = 0.0;
+    double total_satisfaction_monotonicity_ = 0.0;
+    double total_satisfaction_range_ = 0.0;
+    double total_satisfaction_condorcet_ = 0.0;
+    double total_satisfaction_borda_ = 0.0;
+    double total_satisfaction_approval_ = 0.0;
+    double total_satisfaction_ranked_ = 0.0;
+    double total_satisfaction_plurality_ = 0.0;
+    int majority_winners_ = 0;
+    double min_satisfaction_ = 1.0;
+    int winner_maximizes_satisfaction_ = 0;
+    int winner_is_range_ = 0;
+    int winner_is_condorcet_ = 0;
+    int condorcet_cycles_ = 0;
+    int winner_is_borda_ = 0;
+    int winner_is_approval_ = 0;
+    int winner_is_ranked_ = 0;
+    int winner_is_plurality_ = 0;
+    int monotonicity_ = 0;
+
+    void add(
+        const Totals& other
+    ) noexcept {
+        total_satisfaction_ += other.total_satisfaction_;
+        total_satisfaction_monotonicity_ += other.total_satisfaction_monotonicity_;
+        total_satisfaction_range_ += other.total_satisfaction_range_;
+        total_satisfaction_condorcet_ += other.total_satisfaction_condorcet_;
+        total_satisfaction_borda_ += other.total_satisfaction_borda_;
+        total_satisfaction_approval_ += other.total_satisfaction_approval_;
+        total_satisfaction_ranked_ += other.total_satisfaction_ranked_;
+        total_satisfaction_plurality_ += other.total_satisfaction_plurality_;
+        majority_winners_ += other.majority_winners_;
+        min_satisfaction_ = std::min(min_satisfaction_, other.min_satisfaction_);
+        winner_maximizes_satisfaction_ += other.winner_maximizes_satisfaction_;
+        winner_is_range_ += other.winner_is_range_;
+        winner_is_condorcet_ += other.winner_is_condorcet_;
+        condorcet_cycles_ += other.condorcet_cycles_;
+        winner_is_borda_ += other.winner_is_borda_;
+        winner_is_approval_ += other.winner_is_approval_;
+        winner_is_ranked_ += other.winner_is_ranked_;
+        winner_is_plurality_ += other.winner_is_plurality_;
+        monotonicity_ += other.monotonicity_;
+    }
+};
+
 typedef std::vector<int> Rankings;
 typedef std::vector<double> Utilities;
 
@@ -373,7 +433,138 @@ public:
     Utilities utilities_;
 };
 
-typedef std::map<Rankings, Bloc> BlocMap;
+/** sorted by rankings. **/
+typedef std::vector<std::pair<Rankings, Bloc>> BlocMap;
+
+/**
+collect voters with the same rankings into blocs.
+
+the rankings are encoded as an integer.
+up to 20 candidates it's the lehmer code.
+the index of the ranking in the sorted list of all rankings.
+so equal codes are equal rankings.
+more candidates are hashed and compared.
+
+the codes are the keys of an open addressing hash table.
+the table holds the index of the bloc.
+**/
+class BlocBuilder {
+public:
+    BlocBuilder() = default;
+    BlocBuilder(const BlocBuilder &) = delete;
+    ~BlocBuilder() = default;
+
+    static constexpr int kMaxLehmerCandidates = 20;
+
+    /**
+    capacity is the most blocs there could be.
+    there are never more than n! rankings.
+    **/
+    void init(
+        int ncandidates,
+        int capacity
+    ) noexcept {
+        n_ = ncandidates;
+        long factorial = 1;
+        for (int i = 2; i <= n_ && factorial < capacity; ++i) {
+            factorial *= i;
+        }
+        capacity = std::min(long(capacity), factorial);
+        int nslots = 16;
+        while (nslots < 2 * capacity) {
+            nslots *= 2;
+        }
+        mask_ = nslots - 1;
+        slots_.assign(nslots, -1);
+        codes_.clear();
+        blocs_.clear();
+    }
+
+    /** add voters to the bloc with these rankings. **/
+    void add(
+        const int *rankings,
+        const double *utilities,
+        int size
+    ) noexcept {
+        std::uint64_t code = encode(rankings);
+        int slot = int((code * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+        for(;;) {
+            int idx = slots_[slot];
+            if (idx < 0) {
+                /** add a new bloc. **/
+                slots_[slot] = blocs_.size();
+                codes_.push_back(code);
+                Bloc bloc;
+                bloc.size_ = size;
+                bloc.utilities_.assign(utilities, utilities + n_);
+                blocs_.push_back({Rankings(rankings, rankings + n_), std::move(bloc)});
+                return;
+            }
+            if (codes_[idx] == code && is_same(blocs_[idx].first, rankings)) {
+                /** add to the existing bloc. **/
+                auto& bloc = blocs_[idx].second;
+                bloc.size_ += size;
+                for (int i = 0; i < n_; ++i) {
+                    bloc.utilities_[i] += utilities[i];
+                }
+                return;
+            }
+            slot = (slot + 1) & mask_;
+        }
+    }
+
+    /** the blocs sorted by rankings. **/
+    void get(
+        BlocMap& bloc_map
+    ) noexcept {
+        auto cmp = [](const BlocMap::value_type& a, const BlocMap::value_type& b) -> bool {
+            return (a.first < b.first);
+        };
+        std::sort(blocs_.begin(), blocs_.end(), cmp);
+        bloc_map = std::move(blocs_);
+        blocs_.clear();
+    }
+
+private:
+    int n_ = 0;
+    int mask_ = 0;
+    std::vector<int> slots_;
+    std::vector<std::uint64_t> codes_;
+    BlocMap blocs_;
+
+    std::uint64_t encode(
+        const int *rankings
+    ) const noexcept {
+        if (n_ <= kMaxLehmerCandidates) {
+            /** count the smaller candidates not yet ranked. **/
+            std::uint64_t code = 0;
+            std::uint32_t unranked = (1U << n_) - 1;
+            for (int i = 0; i < n_; ++i) {
+                int r = rankings[i];
+                int smaller = std::popcount(unranked & ((1U << r) - 1));
+                code = code * std::uint64_t(n_ - i) + std::uint64_t(smaller);
+                unranked &= ~(1U << r);
+            }
+            return code;
+        }
+        /** fnv-1a. **/
+        std::uint64_t code = 0xCBF29CE484222325ULL;
+        for (int i = 0; i < n_; ++i) {
+            code = (code ^ std::uint64_t(rankings[i])) * 0x100000001B3ULL;
+        }
+        return code;
+    }
+
+    bool is_same(
+        const Rankings& a,
+        const int *b
+    ) const noexcept {
+        if (n_ <= kMaxLehmerCandidates) {
+            return true;
+        }
+        return std::equal(a.begin(), a.end(), b);
+    }
+};
 
 class GuthrieImpl {
 public:
@@ -391,74 +582,63 @@ public:
     Electorate electorate_;
     Candidates candidates_;
     BlocMap bloc_map_;
+    PairwiseMatrix pairwise_;
 
     /** results from the trial. **/
     int winner_ = 0;
     SatisfactionMetrics theoretical_;
     SatisfactionMetrics actual_;
 
+    /** the random numbers for the trial. **/
+    Rng rng_;
+    std::uint64_t seed_ = 0;
+    int nthreads_ = kNThreads;
+    /** trials on many threads don't log the details. **/
+    bool quiet_ = false;
+
     /** summary **/
-    double total_satisfaction_ = 0.0;
-    double total_satisfaction_monotonicity_ = 0.0;
-    double total_satisfaction_range_ = 0.0;
-    double total_satisfaction_condorcet_ = 0.0;
-    double total_satisfaction_borda_ = 0.0;
-    double total_satisfaction_approval_ = 0.0;
-    double total_satisfaction_ranked_ = 0.0;
-    double total_satisfaction_plurality_ = 0.0;
-    int majority_winners_ = 0;
-    double min_satisfaction_ = 1.0;
-    int winner_maximizes_satisfaction_ = 0;
-    int winner_is_range_ = 0;
-    int winner_is_condorcet_ = 0;
-    int condorcet_cycles_ = 0;
-    int winner_is_borda_ = 0;
-    int winner_is_approval_ = 0;
-    int winner_is_ranked_ = 0;
-    int winner_is_plurality_ = 0;
-    int monotonicity_ = 0;
+    Totals totals_;
 
-    void run() noexcept {
-        /** initialize the random number generators. **/
-        RandomNumberGenerator::init(kSeedChoice);
+    void run() noexcept;
 
-        /** configure the electorate. **/
+    void configure() noexcept {
         electorate_.nvoters_ = kNVoters;
         electorate_.method_ = kElectorateMethod;
         electorate_.naxes_ = kNAxes;
         electorate_.axis_weight_decay_ = kAxisWeightDecay;
         electorate_.nclusters_ = kNClusters;
+        electorate_.quiet_ = quiet_;
 
-        /** some sanity checks. **/
-        sanity_checks();
-
-        /** hello, world. **/
-        LOG("Guthrie voting analysis:");
-        show_header();
-
-        /** run many trials. **/
-        for (int trial = 1; trial <= ntrials_; ++trial) {
-            if (ntrials_ > 1) {
-                LOG("");
-                LOG("Trial: "<<trial);
-            }
-
-            /** initialize the electorate and candidates. **/
-            electorate_.init();
-            if (kShowElectorateDistribution) {
-                electorate_.show_distribution();
-            }
-            find_best_candidate();
-            init_candidates();
-            calculate_utilities(actual_);
-            vote();
-            find_winner();
-            show_satisfaction();
-            check_criteria();
+        /** uniform electorate is a single axis. **/
+        if (kElectorateMethod == kElectorateUniform) {
+            electorate_.naxes_ = 1;
         }
+    }
 
-        /** log the results. **/
-        show_summary();
+    /** run trials until there are none left. **/
+    void run_trial(
+        int trial
+    ) noexcept {
+        if (ntrials_ > 1) {
+            LOG_DETAILS("");
+            LOG_DETAILS("Trial: "<<trial);
+        }
+
+        /** the trial's random numbers depend only on the seed and the trial. **/
+        rng_.init(seed_, trial);
+
+        /** initialize the electorate and candidates. **/
+        electorate_.init(rng_);
+        if (kShowElectorateDistribution) {
+            electorate_.show_distribution();
+        }
+        find_best_candidate();
+        init_candidates();
+        calculate_utilities(actual_);
+        vote();
+        find_winner();
+        show_satisfaction();
+        check_criteria();
     }
 
     void sanity_checks() noexcept {
@@ -475,27 +655,24 @@ public:
             exit(1);
         }
 
-        /** uniform electorate is a single axis. **/
+        /** uniform electorate is a single axis. see configure. **/
         if (kElectorateMethod == kElectorateUniform) {
-            if (electorate_.naxes_ != 1) {
-                LOG("Warning: Uniform electorate requires number of issue axes ("<<electorate_.naxes_<<") to be 1, overriding.");
-                electorate_.naxes_ = 1;
+            if (kNAxes != 1) {
+                LOG("Warning: Uniform electorate requires number of issue axes ("<<kNAxes<<") to be 1, overriding.");
             }
         }
     }
 
     /** show configuration. **/
     void show_header() noexcept {
-        auto seed = Rng::get_seed();
-
         LOG("Configuration:");
         LOG("Number trials    : "<<ntrials_);
         LOG("Number voters    : "<<electorate_.nvoters_);
         LOG("Number candidates: "<<ncandidates_);
         if (kSeedChoice == 0) {
-            LOG("Random seed      : "<<seed);
+            LOG("Random seed      : "<<seed_);
         } else {
-            LOG("Fixed seed       : "<<seed);
+            LOG("Fixed seed       : "<<seed_);
         }
         switch (electorate_.method_) {
         case kElectorateUniform:
@@ -524,24 +701,27 @@ public:
             return;
         }
 
+        /** every voter is a candidate. **/
+        int nvoters = electorate_.nvoters_;
+        std::vector<Position> positions(nvoters);
+        for (int i = 0; i < nvoters; ++i) {
+            positions[i] = electorate_.get_position(i);
+        }
+        std::vector<double> sums;
+        electorate_.get_utility_sums(positions, sums);
+
         int best = 0;
-        double best_utility = 1e99;
-        Position *best_position = nullptr;
+        double best_utility = -1e99;
         double total_utility = 0.0;
-        for (int i = 0; i < electorate_.nvoters_; ++i) {
-            auto& ipos = electorate_.voters_[i].position_;
-            double utility = 0.0;
-            for (int k = 0; k < electorate_.nvoters_; ++k) {
-                auto& kpos = electorate_.voters_[k].position_;
-                utility += ipos.utility(kpos);
-            }
+        for (int i = 0; i < nvoters; ++i) {
+            double utility = sums[i];
             if (utility > best_utility) {
                 best = i;
                 best_utility = utility;
-                best_position = &ipos;
             }
             total_utility += utility;
         }
+        auto best_position = electorate_.get_position(best);
 
         /**
         save the best candidate and utility.
@@ -552,10 +732,10 @@ public:
         theoretical_.average_ = total_utility / double(electorate_.nvoters_);
 
         /** show results. **/
-        LOG("Best candidate chosen from all voters:");
-        LOG(" Position: "<<best_position->to_string());
-        LOG(" Utility : "<<best_utility);
-        LOG(" Average : "<<theoretical_.average_);
+        LOG_DETAILS("Best candidate chosen from all voters:");
+        LOG_DETAILS(" Position: "<<best_position.to_string());
+        LOG_DETAILS(" Utility : "<<best_utility);
+        LOG_DETAILS(" Average : "<<theoretical_.average_);
     }
 
     void init_candidates() noexcept {
@@ -567,7 +747,7 @@ public:
         figure out how candidates rank each other.
         calculate voter satisfactions.
         **/
-        LOG("Selecting candidates from the electorate.");
+        LOG_DETAILS("Selecting candidates from the electorate.");
         pick_candidates_from_electorate();
         /** sort them. **/
         std::sort(candidates_.begin(), candidates_.end());
@@ -593,7 +773,7 @@ public:
         }
 
         if (n > ncandidates_) {
-            LOG("Reducing the number of candidates from "<<n<<" to "<<ncandidates_<<".");
+            LOG_DETAILS("Reducing the number of candidates from "<<n<<" to "<<ncandidates_<<".");
         }
 
         /** allocate space **/
@@ -612,14 +792,14 @@ public:
         for (auto&& candidate : candidates_) {
             int i = 0;
             for(;;) {
-                i = Rng::generate(electorate_.nvoters_);
+                i = rng_.generate(electorate_.nvoters_);
                 if (duplicates[i] == false) {
                     break;
                 }
             }
             duplicates[i] = true;
             candidate.name_ = name++;
-            candidate.position_ = electorate_.voters_[i].position_;
+            candidate.position_ = electorate_.get_position(i);
         }
     }
 
@@ -664,9 +844,9 @@ public:
     }
 
     void show_candidate_positions() noexcept {
-        LOG("Candidate positions:");
+        LOG_DETAILS("Candidate positions:");
         for (auto&& candidate : candidates_ ) {
-            LOG(" "<<candidate.name_<<": "<<candidate.position_.to_string());
+            LOG_DETAILS(" "<<candidate.name_<<": "<<candidate.position_.to_string());
         }
     }
 
@@ -679,7 +859,7 @@ public:
         }
 
         if (quiet == false) {
-            LOG("Candidate rankings of other candidates:");
+            LOG_DETAILS("Candidate rankings of other candidates:");
             for (auto&& candidate : candidates_ ) {
                 std::stringstream ss;
                 ss<<" "<<candidate.name_<<":";
@@ -691,7 +871,7 @@ public:
                     }
                     ss<<" "<<candidates_[rank].name_<<" ("<<utility<<")";
                 }
-                LOG(ss.str());
+                LOG_DETAILS(ss.str());
             }
         }
     }
@@ -781,48 +961,40 @@ public:
         when there are 3 candidates...
         the voters can only be ABC, ACB, BAC, BCA, CAB, CBA.
         **/
-        bloc_map_.clear();
-        Rankings rankings;
-        Utilities utilities;
         int n = candidates_.size();
+        BlocBuilder builder;
+        builder.init(n, electorate_.nvoters_);
+        std::vector<int> rankings(n);
+        std::vector<double> utilities(n);
+
+        /** every voter's utility for every candidate at once. **/
+        std::vector<Position> positions;
+        positions.reserve(n);
+        for (auto&& candidate : candidates_) {
+            positions.push_back(candidate.position_);
+        }
+        std::vector<double> matrix;
+        electorate_.get_utilities(positions, matrix);
 
-        for (auto&& voter : electorate_.voters_) {
-            rankings.reserve(n);
-            utilities.reserve(n);
-            rankings.clear();
-            utilities.clear();
-
-            /** create the rankings and the utility. **/
+        for (int v = 0; v < electorate_.nvoters_; ++v) {
+            auto row = &matrix[std::size_t(v) * n];
+            /** sort the candidates by utility. ties keep their order. **/
             for (int i = 0; i < n; ++i) {
-                auto& candidate = candidates_[i];
-                double utility = voter.position_.utility(candidate.position_);
-                int k = 0;
-                for (; k < i; ++k) {
-                    if (utility > utilities[k]) {
+                double utility = row[i];
+                int k = i;
+                for (; k > 0; --k) {
+                    if (utility <= utilities[k-1]) {
                         break;
                     }
+                    rankings[k] = rankings[k-1];
+                    utilities[k] = utilities[k-1];
                 }
-                rankings.insert(rankings.begin() + k, i);
-                utilities.insert(utilities.begin() + k, utility);
-            }
-
-            /** find the key. **/
-            auto it = bloc_map_.find(rankings);
-            if (it == bloc_map_.end()) {
-                /** add new bloc. **/
-                Bloc bloc;
-                bloc.size_ = 1;
-                bloc.utilities_ = std::move(utilities);
-                bloc_map_.insert({std::move(rankings), std::move(bloc)});
-            } else {
-                /** add to the existing bloc. **/
-                auto& found_bloc = it->second;
-                ++found_bloc.size_;
-                for (int i = 0; i < n; ++i) {
-                    found_bloc.utilities_[i] += utilities[i];
-                }
+                rankings[k] = i;
+                utilities[k] = utility;
             }
+            builder.add(rankings.data(), utilities.data(), 1);
         }
+        builder.get(bloc_map_);
     }
 
     /**
@@ -833,21 +1005,16 @@ public:
     void reduce_blocs(
         int k
     ) noexcept {
-        Rankings new_rankings;
-        Utilities new_utilities;
-        BlocMap new_bloc_map;
-
         int n = candidates_.size();
+        BlocBuilder builder;
+        builder.init(n, bloc_map_.size());
+        std::vector<int> new_rankings(n);
+        std::vector<double> new_utilities(n);
 
         for (auto&& it : bloc_map_) {
             auto& rankings = it.first;
             auto& bloc = it.second;
 
-            new_rankings.reserve(n);
-            new_utilities.reserve(n);
-            new_rankings.clear();
-            new_utilities.clear();
-
             /**
             copy the old rankings and utilities
             omitting the former k-th candidate.
@@ -856,47 +1023,34 @@ public:
             the original block map has keys of size n+1.
             hence the less than or equal.
             **/
+            int dst = 0;
             for (int i = 0; i <= n; ++i) {
                 int r = rankings[i];
                 if (r == k) {
                     /** skip the removed candidate. **/
                     continue;
                 }
-                double u = bloc.utilities_[i];
                 int new_r = r;
                 if (new_r > k) {
                     /** later candidates change index. **/
                     --new_r;
                 }
-                new_rankings.push_back(new_r);
-                new_utilities.push_back(u);
+                new_rankings[dst] = new_r;
+                new_utilities[dst] = bloc.utilities_[i];
+                ++dst;
             }
 
-            /** find the new rankings in the map. **/
-            auto rit = new_bloc_map.find(new_rankings);
-            if (rit == new_bloc_map.end()) {
-                /** add a new bloc. **/
-                Bloc new_bloc;
-                new_bloc.size_ = bloc.size_;
-                new_bloc.utilities_ = std::move(new_utilities);
-                new_bloc_map.insert({std::move(new_rankings), std::move(new_bloc)});
-            } else {
-                /** accumulate into an existing bloc. **/
-                auto& found_bloc = rit->second;
-                found_bloc.size_ += bloc.size_;
-                for (int i = 0; i < n; ++i) {
-                    found_bloc.utilities_[i] += new_utilities[i];
-                }
-            }
+            /** blocs that differed only by the removed candidate merge. **/
+            builder.add(new_rankings.data(), new_utilities.data(), bloc.size_);
         }
 
         /** blow away the old bloc. **/
-        bloc_map_ = std::move(new_bloc_map);
+        builder.get(bloc_map_);
     }
 
     void show_bloc_map() noexcept {
         int n = bloc_map_.size();
-        LOG("Voter blocs ("<<n<<"):");
+        LOG_DETAILS("Voter blocs ("<<n<<"):");
         for (auto&& it : bloc_map_) {
             auto& rankings = it.first;
             auto& bloc = it.second;
@@ -911,7 +1065,7 @@ public:
             for (int i = 0; i < nrankings; ++i) {
                 ss<<" "<<bloc.utilities_[i];
             }
-            LOG(ss.str());
+            LOG_DETAILS(ss.str());
         }
     }
 
@@ -954,7 +1108,7 @@ public:
         **/
         for (int round = 1; /*round < ncandidates_*/; ++round) {
             if (show_everything) {
-                LOG("Round "<<round<<":");
+                LOG_DETAILS("Round "<<round<<":");
             }
 
             /** phase 1: count first place votes. **/
@@ -976,10 +1130,10 @@ public:
                 show_it = true;
             }
             if (show_it) {
-                LOG("First place vote counts:");
+                LOG_DETAILS("First place vote counts:");
                 for (int i = 0; i < ncandidates_; ++i) {
                     auto& candidate = candidates_[i];
-                    LOG(" "<<candidate.name_<<": "<<counts[i]);
+                    LOG_DETAILS(" "<<candidate.name_<<": "<<counts[i]);
                 }
             }
 
@@ -989,7 +1143,7 @@ public:
                     winner_ = i;
                     if (show_required) {
                         auto& candidate = candidates_[i];
-                        LOG(candidate.name_<<" wins Guthrie voting in round "<<round<<".");
+                        LOG_DETAILS(candidate.name_<<" wins Guthrie voting in round "<<round<<".");
                     }
                     return;
                 }
@@ -1038,16 +1192,16 @@ public:
             }
 
             if (show_everything) {
-                LOG("No candidate has a majority.");
+                LOG_DETAILS("No candidate has a majority.");
 
-                LOG("Last place vote counts:");
+                LOG_DETAILS("Last place vote counts:");
                 for (int i = 0; i < ncandidates_; ++i) {
                     auto& candidate = candidates_[i];
-                    LOG(" "<<candidate.name_<<": "<<counts[i]);
+                    LOG_DETAILS(" "<<candidate.name_<<": "<<counts[i]);
                 }
-                LOG(" Candidate "<<candidates_[loser].name_<<" has the most last place votes - eliminated.");
+                LOG_DETAILS(" Candidate "<<candidates_[loser].name_<<" has the most last place votes - eliminated.");
 
-                LOG("Updated rankings:");
+                LOG_DETAILS("Updated rankings:");
                 for (auto&& candidate : candidates_ ) {
                     std::stringstream ss;
                     ss<<" "<<candidate.name_<<":";
@@ -1058,7 +1212,7 @@ public:
                         }
                         ss<<" "<<candidates_[rank].name_;
                     }
-                    LOG(ss.str());
+                    LOG_DETAILS(ss.str());
                 }
             }
         }
@@ -1076,12 +1230,12 @@ public:
     all possible: includes all voters.
     **/
     void show_satisfaction() noexcept {
-        LOG("");
-        LOG("Voter satisfaction (utility):");
+        LOG_DETAILS("");
+        LOG_DETAILS("Voter satisfaction (utility):");
         calculate_satisfaction(actual_);
 
         if (kFindTheoreticalBestCandidate) {
-            LOG("Voter satisfaction (all possible):");
+            LOG_DETAILS("Voter satisfaction (all possible):");
             calculate_satisfaction(theoretical_);
         }
     }
@@ -1095,7 +1249,7 @@ public:
         for (auto&& candidate : candidates_) {
             double dutility = candidate.utility_ - average;
             double satisfaction = dutility / denom;
-            LOG(" "<<candidate.name_<<": "<<satisfaction<<" ("<<dutility<<")");
+            LOG_DETAILS(" "<<candidate.name_<<": "<<satisfaction<<" ("<<dutility<<")");
         }
     }
 
@@ -1110,8 +1264,8 @@ public:
     }
 
     void check_criteria() noexcept {
-        LOG("");
-        LOG("Checking voting criteria.");
+        LOG_DETAILS("");
+        LOG_DETAILS("Checking voting criteria.");
         int max_satisfaction = find_max_satisfaction_candidate();
         int range = find_range_winner();
         int condorcet = find_condorcet_winner();
@@ -1122,28 +1276,28 @@ public:
         int monotonicity = check_monotonicity();
 
         if (winner_ == max_satisfaction) {
-            ++winner_maximizes_satisfaction_;
+            ++totals_.winner_maximizes_satisfaction_;
         }
         if (winner_ == range) {
-            ++winner_is_range_;
+            ++totals_.winner_is_range_;
         }
         if (winner_ == condorcet) {
-            ++winner_is_condorcet_;
+            ++totals_.winner_is_condorcet_;
         }
         if (winner_ == borda) {
-            ++winner_is_borda_;
+            ++totals_.winner_is_borda_;
         }
         if (winner_ == approval) {
-            ++winner_is_approval_;
+            ++totals_.winner_is_approval_;
         }
         if (winner_ == ranked) {
-            ++winner_is_ranked_;
+            ++totals_.winner_is_ranked_;
         }
         if (winner_ == plurality) {
-            ++winner_is_plurality_;
+            ++totals_.winner_is_plurality_;
         }
         if (winner_ == monotonicity) {
-            ++monotonicity_;
+            ++totals_.monotonicity_;
         }
 
         char condorcet_name = '?';
@@ -1151,26 +1305,26 @@ public:
             condorcet_name = candidates_[condorcet].name_;
         }
 
-        LOG("");
-        LOG("Voting criteria results:");
+        LOG_DETAILS("");
+        LOG_DETAILS("Voting criteria results:");
         const char *result = nullptr;
-        LOG("Guthrie winner              : "<<candidates_[winner_].name_);
+        LOG_DETAILS("Guthrie winner              : "<<candidates_[winner_].name_);
         result = result_to_string(winner_, max_satisfaction);
-        LOG("Maximizes voter satisfaction: "<<candidates_[max_satisfaction].name_<<" "<<result);
+        LOG_DETAILS("Maximizes voter satisfaction: "<<candidates_[max_satisfaction].name_<<" "<<result);
         result = result_to_string(winner_, range);
-        LOG("Range winner                : "<<candidates_[range].name_<<" "<<result);
+        LOG_DETAILS("Range winner                : "<<candidates_[range].name_<<" "<<result);
         result = result_to_string(winner_, condorcet);
-        LOG("Condorcet winner            : "<<condorcet_name<<" "<<result);
+        LOG_DETAILS("Condorcet winner            : "<<condorcet_name<<" "<<result);
         result = result_to_string(winner_, borda);
-        LOG("Borda winner                : "<<candidates_[borda].name_<<" "<<result);
+        LOG_DETAILS("Borda winner                : "<<candidates_[borda].name_<<" "<<result);
         result = result_to_string(winner_, approval);
-        LOG("Approval winner             : "<<candidates_[approval].name_<<" "<<result);
+        LOG_DETAILS("Approval winner             : "<<candidates_[approval].name_<<" "<<result);
         result = result_to_string(winner_, ranked);
-        LOG("Ranked choice winner (IRV)  : "<<candidates_[ranked].name_<<" "<<result);
+        LOG_DETAILS("Ranked choice winner (IRV)  : "<<candidates_[ranked].name_<<" "<<result);
         result = result_to_string(winner_, plurality);
-        LOG("Plurality winner            : "<<candidates_[plurality].name_<<" "<<result);
+        LOG_DETAILS("Plurality winner            : "<<candidates_[plurality].name_<<" "<<result);
         result = result_to_string(winner_, monotonicity);
-        LOG("Monotonicity                : "<<candidates_[monotonicity].name_<<" "<<result);
+        LOG_DETAILS("Monotonicity                : "<<candidates_[monotonicity].name_<<" "<<result);
     }
 
     const char *result_to_string(int winner, int expected) noexcept {
@@ -1192,8 +1346,8 @@ public:
         double satisfaction = calculate_satisfaction(winning_candidate.utility_, actual_);
 
         /** update summary **/
-        total_satisfaction_ += satisfaction;
-        min_satisfaction_ = std::min(min_satisfaction_, satisfaction);
+        totals_.total_satisfaction_ += satisfaction;
+        totals_.min_satisfaction_ = std::min(totals_.min_satisfaction_, satisfaction);
 
         return satisfaction_winner;
     }
@@ -1239,7 +1393,7 @@ public:
         /** accumulate the satisfaction. **/
         auto& candidate = candidates_[winner];
         double sat = calculate_satisfaction(candidate.utility_, actual_);
-        total_satisfaction_range_ += sat;
+        totals_.total_satisfaction_range_ += sat;
 
         return winner;
     }
@@ -1252,10 +1406,31 @@ public:
         int loser_votes_ = 0;
     };
 
+    /** every head to head race at once. **/
+    void build_pairwise() noexcept {
+        int nblocs = bloc_map_.size();
+        std::vector<int> ranks(nblocs * ncandidates_, ncandidates_);
+        std::vector<int> weights(nblocs);
+        int i = 0;
+        for (auto&& it : bloc_map_) {
+            auto& rankings = it.first;
+            auto& bloc = it.second;
+            auto dst = &ranks[i * ncandidates_];
+            for (int rank = 0, nranks = rankings.size(); rank < nranks; ++rank) {
+                dst[rankings[rank]] = rank;
+            }
+            weights[i] = bloc.size_;
+            ++i;
+        }
+        pairwise_.init(ranks, weights, ncandidates_);
+    }
+
     /**
     condorcet wins the most head to head races.
     **/
     int find_condorcet_winner() noexcept {
+        build_pairwise();
+
         /** initialize number of wins for each candidate. **/
         std::vector<int> wins;
         wins.resize(ncandidates_);
@@ -1263,13 +1438,13 @@ public:
             wins[i] = 0;
         }
 
-        LOG("Condorcet results:");
+        LOG_DETAILS("Condorcet results:");
         /** count head to head victories. **/
         for (int i = 0; i < ncandidates_; ++i) {
             for (int k = i + 1; k < ncandidates_; ++k) {
                 HeadToHead result;
                 head_to_head(i, k, result);
-                LOG(" "<<candidates_[result.winner_].name_<<" ("<<result.winner_votes_<<") > "
+                LOG_DETAILS(" "<<candidates_[result.winner_].name_<<" ("<<result.winner_votes_<<") > "
                     <<candidates_[result.loser_].name_<<" ("<<result.loser_votes_<<")");
                 ++wins[result.winner_];
             }
@@ -1303,9 +1478,9 @@ public:
 
         /** no winner if there's a cycle. **/
         if (nwinners > 1) {
-            LOG("Condorcet cycle exists.");
+            LOG_DETAILS("Condorcet cycle exists.");
             winner = -1;
-            ++condorcet_cycles_;
+            ++totals_.condorcet_cycles_;
         }
 
         /**
@@ -1313,7 +1488,7 @@ public:
         accumulate for the summary.
         **/
         double utility = total_utility / double(nwinners);
-        total_satisfaction_condorcet_ += calculate_satisfaction(utility, actual_);
+        totals_.total_satisfaction_condorcet_ += calculate_satisfaction(utility, actual_);
 
         return winner;
     }
@@ -1327,27 +1502,8 @@ public:
         int b,
         HeadToHead &result
     ) noexcept {
-        /** init vote counts. **/
-        int avotes = 0;
-        int bvotes = 0;
-
-        /** for each voter bloc. **/
-        for (auto&& it : bloc_map_) {
-            auto& rankings = it.first;
-            auto& bloc = it.second;
-
-            /** give the votes to whichever is first. */
-            for (auto&& which : rankings) {
-                if (which == a) {
-                    avotes += bloc.size_;
-                    break;
-                }
-                if (which == b) {
-                    bvotes += bloc.size_;
-                    break;
-                }
-            }
-        }
+        int avotes = pairwise_.votes(a, b);
+        int bvotes = pairwise_.votes(b, a);
 
         /**
         we assume that a comes before b in the candidate list.
@@ -1404,7 +1560,7 @@ public:
         /** accumulate the satisfaction. **/
         auto& candidate = candidates_[winner];
         double sat = calculate_satisfaction(candidate.utility_, actual_);
-        total_satisfaction_borda_ += sat;
+        totals_.total_satisfaction_borda_ += sat;
 
         return winner;
     }
@@ -1456,7 +1612,7 @@ public:
         /** accumulate the satisfaction. **/
         auto& candidate = candidates_[winner];
         double sat = calculate_satisfaction(candidate.utility_, actual_);
-        total_satisfaction_approval_ += sat;
+        totals_.total_satisfaction_approval_ += sat;
 
         return winner;
     }
@@ -1563,13 +1719,13 @@ public:
         }
 
         if (ranked_winner < 0) {
-            LOG("=tsc= uh oh! irv failed to find winner." );
+            LOG_DETAILS("=tsc= uh oh! irv failed to find winner." );
         }
 
         /** accumulate the satisfaction. **/
         auto& candidate = candidates_[ranked_winner];
         double sat = calculate_satisfaction(candidate.utility_, actual_);
-        total_satisfaction_ranked_ += sat;
+        totals_.total_satisfaction_ranked_ += sat;
 
         return ranked_winner;
     }
@@ -1610,11 +1766,11 @@ public:
         /** accumulate the satisfaction. **/
         auto& candidate = candidates_[winner];
         double sat = calculate_satisfaction(candidate.utility_, actual_);
-        total_satisfaction_plurality_ += sat;
+        totals_.total_satisfaction_plurality_ += sat;
 
         /** was it a majority? **/
         if (2*votes > electorate_.nvoters_) {
-            ++majority_winners_;
+            ++totals_.majority_winners_;
         }
 
         return winner;
@@ -1659,7 +1815,7 @@ public:
                 char winner_name = candidate.name_;
                 if (winner_name != original_winner_name) {
                     monotonicity = i;
-                    LOG(winner_name<<" wins if "<<original_candidates[i].name_<<" doesn't run.");
+                    LOG_DETAILS(winner_name<<" wins if "<<original_candidates[i].name_<<" doesn't run.");
                     ++nwinners;
                     total_utility += candidate.utility_;
                 }
@@ -1691,7 +1847,7 @@ public:
             utility = total_utility / double(nwinners);
         }
         double sat = calculate_satisfaction(utility, actual_);
-        total_satisfaction_monotonicity_ += sat;
+        totals_.total_satisfaction_monotonicity_ += sat;
 
         return monotonicity;
     }
@@ -1702,29 +1858,29 @@ public:
         }
 
         double denom = double(ntrials_);
-        double non_cycle_trials = double(ntrials_ - condorcet_cycles_);
-        double satisfaction = total_satisfaction_ / denom;
-        double min_satisfaction = min_satisfaction_;
+        double non_cycle_trials = double(ntrials_ - totals_.condorcet_cycles_);
+        double satisfaction = totals_.total_satisfaction_ / denom;
+        double min_satisfaction = totals_.min_satisfaction_;
         double regret = 1.0 - satisfaction;
         double max_regret = 1.0 - min_satisfaction;
-        double satisfaction_monotonicity = total_satisfaction_monotonicity_ / denom;
-        double satisfaction_range = total_satisfaction_range_/ denom;
-        double satisfaction_condorcet = total_satisfaction_condorcet_/ denom;
-        double satisfaction_borda = total_satisfaction_borda_/ denom;
-        double satisfaction_approval = total_satisfaction_approval_/ denom;
-        double satisfaction_ranked = total_satisfaction_ranked_/ denom;
-        double satisfaction_plurality = total_satisfaction_plurality_ / denom;
-        double maximizes_satisfaction = 100.0 * double(winner_maximizes_satisfaction_) / denom;
-        double is_range = 100.0 * double(winner_is_range_) / denom;
-        double is_condorcet_min = 100.0 * double(winner_is_condorcet_) / denom;
-        double is_condorcet_max = 100.0 * double(winner_is_condorcet_) / non_cycle_trials;
-        double is_borda = 100.0 * double(winner_is_borda_) / denom;
-        double is_approval = 100.0 * double(winner_is_approval_) / denom;
-        double is_ranked = 100.0 * double(winner_is_ranked_) / denom;
-        double is_plurality = 100.0 * double(winner_is_plurality_) / denom;
-        double monotonicity = 100.0 * double(monotonicity_) / denom;
-        double majority_winners = 100.0 * double(majority_winners_) / denom;
-        double condorcet_cycles = 100.0 * double(condorcet_cycles_) / denom;
+        double satisfaction_monotonicity = totals_.total_satisfaction_monotonicity_ / denom;
+        double satisfaction_range = totals_.total_satisfaction_range_/ denom;
+        double satisfaction_condorcet = totals_.total_satisfaction_condorcet_/ denom;
+        double satisfaction_borda = totals_.total_satisfaction_borda_/ denom;
+        double satisfaction_approval = totals_.total_satisfaction_approval_/ denom;
+        double satisfaction_ranked = totals_.total_satisfaction_ranked_/ denom;
+        double satisfaction_plurality = totals_.total_satisfaction_plurality_ / denom;
+        double maximizes_satisfaction = 100.0 * double(totals_.winner_maximizes_satisfaction_) / denom;
+        double is_range = 100.0 * double(totals_.winner_is_range_) / denom;
+        double is_condorcet_min = 100.0 * double(totals_.winner_is_condorcet_) / denom;
+        double is_condorcet_max = 100.0 * double(totals_.winner_is_condorcet_) / non_cycle_trials;
+        double is_borda = 100.0 * double(totals_.winner_is_borda_) / denom;
+        double is_approval = 100.0 * double(totals_.winner_is_approval_) / denom;
+        double is_ranked = 100.0 * double(totals_.winner_is_ranked_) / denom;
+        double is_plurality = 100.0 * double(totals_.winner_is_plurality_) / denom;
+        double monotonicity = 100.0 * double(totals_.monotonicity_) / denom;
+        double majority_winners = 100.0 * double(totals_.majority_winners_) / denom;
+        double condorcet_cycles = 100.0 * double(totals_.condorcet_cycles_) / denom;
 
         LOG("");
         show_header();
@@ -1752,6 +1908,54 @@ public:
     }
 };
 
+void GuthrieImpl::run() noexcept {
+    /** every trial has its own stream from this seed. **/
+    seed_ = kSeedChoice;
+    if (seed_ == 0) {
+        seed_ = Rng::make_seed();
+    }
+
+    nthreads_ = parallel_threads(nthreads_, ntrials_);
+    quiet_ = (nthreads_ > 1);
+
+    /** configure the electorate. **/
+    configure();
+
+    /** some sanity checks. **/
+    sanity_checks();
+
+    /** hello, world. **/
+    LOG("Guthrie voting analysis:");
+    show_header();
+    LOG("Number threads   : "<<nthreads_);
+
+    /** the master thread runs trials with this one. the others get their own. **/
+    std::vector<GuthrieImpl> workers(nthreads_ - 1);
+    for (auto&& worker : workers) {
+        worker.seed_ = seed_;
+        worker.quiet_ = true;
+        worker.configure();
+    }
+
+    /** run many trials. **/
+    std::vector<Totals> trial_totals(ntrials_);
+    parallel_for(nthreads_, ntrials_, [&](int thread, int i) {
+        auto impl = (thread == 0) ? this : &workers[thread - 1];
+        impl->totals_ = Totals();
+        impl->run_trial(i + 1);
+        trial_totals[i] = impl->totals_;
+    });
+
+    /** sum the trials in order. so the sums don't depend on the threads. **/
+    totals_ = Totals();
+    for (auto&& totals : trial_totals) {
+        totals_.add(totals);
+    }
+
+    /** log the results. **/
+    show_summary();
+}
+
 } // anonymous namespace
 
 GuthrieVoting::GuthrieVoting() noexcept {
@@ -0,0 +1,450 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+kemeny young.
+
+the greedy ranking improved by swapping neighbors
+is the first bound for branch and bound.
+it's usually the answer.
+
+the subset method needs the votes for a candidate over a set of candidates.
+the sums for every byte of the set are tabulated.
+so it's a few lookups instead of a loop.
+**/
+
+#include "kemeny.h"
+#include "parallel.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <mutex>
+
+
+namespace {
+    /** votes as a square matrix of longs. **/
+    std::vector<long> get_votes(
+        const PairwiseMatrix& matrix
+    ) noexcept {
+        int n = matrix.ncandidates();
+        std::vector<long> votes(n * n);
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) {
+                votes[a * n + b] = matrix.votes(a, b);
+            }
+        }
+        return votes;
+    }
+
+    long score_ranking(
+        const std::vector<long>& votes,
+        const std::vector<int>& ranking
+    ) noexcept {
+        int n = ranking.size();
+        long score = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int k = i + 1; k < n; ++k) {
+                score += votes[ranking[i] * n + ranking[k]];
+            }
+        }
+        return score;
+    }
+
+    /**
+    repeatedly pick the candidate who beats the rest by the most.
+    then swap neighbors while it helps.
+    **/
+    std::vector<int> greedy_ranking(
+        const std::vector<long>& votes,
+        int n
+    ) noexcept {
+        std::vector<int> ranking;
+        std::vector<char> used(n, 0);
+        for (int i = 0; i < n; ++i) {
+            int best = -1;
+            long best_margin = 0;
+            for (int c = 0; c < n; ++c) {
+                if (used[c]) {
+                    continue;
+                }
+                long margin = 0;
+                for (int b = 0; b < n; ++b) {
+                    if (used[b] == 0) {
+                        margin += votes[c * n + b] - votes[b * n + c];
+                    }
+                }
+                if (best < 0 || margin > best_margin) {
+                    best = c;
+                    best_margin = margin;
+                }
+            }
+            used[best] = 1;
+            ranking.push_back(best);
+        }
+
+        bool swapped = true;
+        while (swapped) {
+            swapped = false;
+            for (int i = 0; i + 1 < n; ++i) {
+                int a = ranking[i];
+                int b = ranking[i+1];
+                if (votes[b * n + a] > votes[a * n + b]) {
+                    std::swap(ranking[i], ranking[i+1]);
+                    swapped = true;
+                }
+            }
+        }
+        return ranking;
+    }
+
+    /**
+    the sum of votes(c, b) for every b in a set.
+    looked up a byte of the set at a time.
+    **/
+    class RowSums {
+    public:
+        static constexpr int kBits = 8;
+        static constexpr int kSize = 1 << kBits;
+
+        RowSums(
+            const std::vector<long>& votes,
+            int n
+        ) noexcept {
+            nchunks_ = (n + kBits - 1) / kBits;
+            sums_.assign(n * nchunks_ * kSize, 0);
+            for (int c = 0; c < n; ++c) {
+                for (int chunk = 0; chunk < nchunks_; ++chunk) {
+                    auto sums = &sums_[(c * nchunks_ + chunk) * kSize];
+                    for (int bits = 1; bits < kSize; ++bits) {
+                        /** the sum without the low bit plus the low bit. **/
+                        int low = std::countr_zero(unsigned(bits));
+                        int b = chunk * kBits + low;
+                        long vote = (b < n) ? votes[c * n + b] : 0;
+                        sums[bits] = sums[bits & (bits - 1)] + vote;
+                    }
+                }
+            }
+        }
+
+        int nchunks_ = 0;
+        std::vector<long> sums_;
+
+        long get(
+            int c,
+            int set
+        ) const noexcept {
+            auto sums = &sums_[c * nchunks_ * kSize];
+            long sum = 0;
+            for (int chunk = 0; chunk < nchunks_; ++chunk) {
+                sum += sums[chunk * kSize + ((set >> (chunk * kBits)) & (kSize - 1))];
+            }
+            return sum;
+        }
+    };
+
+    /** the best ranking so far. shared by all threads. **/
+    class KemenyShared {
+    public:
+        int n_ = 0;
+        const long *votes_ = nullptr;
+        /** the larger of votes(a, b) and votes(b, a). **/
+        std::vector<long> larger_;
+        /** the first two candidates of every subtree. **/
+        std::vector<int> roots_;
+
+        std::atomic<long> best_score_{0};
+        std::mutex best_mutex_;
+        std::vector<int> best_ranking_;
+
+        /**
+        true if a ranking that starts with the prefix
+        and scores at most bound could be better than the best.
+        **/
+        bool could_beat(
+            long bound,
+            const int *prefix,
+            int length
+        ) noexcept {
+            long best = best_score_.load(std::memory_order_relaxed);
+            if (bound != best) {
+                return (bound > best);
+            }
+            std::unique_lock<std::mutex> lock(best_mutex_);
+            return std::lexicographical_compare(best_ranking_.begin(), best_ranking_.begin() + length,
+                prefix, prefix + length) == false;
+        }
+
+        void post(
+            long score,
+            const std::vector<int>& ranking
+        ) noexcept {
+            std::unique_lock<std::mutex> lock(best_mutex_);
+            long best = best_score_.load(std::memory_order_relaxed);
+            if (score < best) {
+                return;
+            }
+            if (score == best && ranking >= best_ranking_) {
+                return;
+            }
+            best_ranking_ = ranking;
+            best_score_.store(score, std::memory_order_relaxed);
+        }
+    };
+
+    class KemenySearch {
+    public:
+        KemenySearch(
+            KemenyShared *shared
+        ) noexcept :
+            shared_(shared) {
+            int n = shared->n_;
+            ranking_.resize(n);
+            used_.resize(n);
+            children_.resize(n * n);
+        }
+
+        KemenyShared *shared_;
+        std::vector<int> ranking_;
+        std::vector<char> used_;
+        /** per depth: gain, bound drop, candidate. **/
+        class Child {
+        public:
+            long gain_;
+            long drop_;
+            int which_;
+        };
+        std::vector<Child> children_;
+
+        /** search one subtree. **/
+        void run(
+            int root
+        ) noexcept {
+            int n = shared_->n_;
+            used_.assign(n, 0);
+            long score = 0;
+            long bound = total_bound();
+            for (int depth = 0; depth < 2; ++depth) {
+                int c = shared_->roots_[2 * root + depth];
+                place(depth, c, score, bound);
+            }
+            search(2, score, bound);
+        }
+
+        /** the most the unranked candidates could add. **/
+        long total_bound() noexcept {
+            int n = shared_->n_;
+            long bound = 0;
+            for (int a = 0; a < n; ++a) {
+                for (int b = a + 1; b < n; ++b) {
+                    bound += shared_->larger_[a * n + b];
+                }
+            }
+            return bound;
+        }
+
+        void place(
+            int depth,
+            int c,
+            long& score,
+            long& bound
+        ) noexcept {
+            int n = shared_->n_;
+            auto votes = shared_->votes_;
+            auto& larger = shared_->larger_;
+            for (int b = 0; b < n; ++b) {
+                if (b != c && used_[b] == 0) {
+                    score += votes[c * n + b];
+                    bound -= larger[c * n + b];
+                }
+            }
+            used_[c] = 1;
+            ranking_[depth] = c;
+        }
+
+        void search(
+            int depth,
+            long score,
+            long bound
+        ) noexcept {
+            int n = shared_->n_;
+            if (shared_->could_beat(score + bound, ranking_.data(), depth) == false) {
+                return;
+            }
+            if (depth == n) {
+                shared_->post(score, ranking_);
+                return;
+            }
+
+            /** most promising first. **/
+            auto votes = shared_->votes_;
+            auto& larger = shared_->larger_;
+            auto children = &children_[depth * n];
+            int nchildren = 0;
+            for (int c = 0; c < n; ++c) {
+                if (used_[c]) {
+                    continue;
+                }
+                auto& child = children[nchildren++];
+                child.gain_ = 0;
+                child.drop_ = 0;
+                child.which_ = c;
+                for (int b = 0; b < n; ++b) {
+                    if (b != c && used_[b] == 0) {
+                        child.gain_ += votes[c * n + b];
+                        child.drop_ += larger[c * n + b];
+                    }
+                }
+            }
+            auto cmp = [](const Child& a, const Child& b) -> bool {
+                if (a.gain_ != b.gain_) {
+                    return (a.gain_ > b.gain_);
+                }
+                return (a.which_ < b.which_);
+            };
+            std::sort(children, children + nchildren, cmp);
+
+            for (int i = 0; i < nchildren; ++i) {
+                auto& child = children[i];
+                used_[child.which_] = 1;
+                ranking_[depth] = child.which_;
+                search(depth + 1, score + child.gain_, bound - child.drop_);
+                used_[child.which_] = 0;
+            }
+        }
+    };
+
+    double elapsed_ms(
+        std::chrono::steady_clock::time_point start
+    ) noexcept {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+}
+
+void KemenyYoung::solve(
+    const PairwiseMatrix& matrix
+) noexcept {
+    if (matrix.ncandidates() <= kMaxSubsetCandidates) {
+        solve_subsets(matrix);
+    } else {
+        solve_branch_and_bound(matrix);
+    }
+}
+
+void KemenyYoung::solve_subsets(
+    const PairwiseMatrix& matrix
+) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    int n = matrix.ncandidates();
+    ranking_.clear();
+    score_ = 0;
+    if (n == 0 || n > kMaxSubsetCandidates) {
+        ms_ = elapsed_ms(start);
+        return;
+    }
+    auto votes = get_votes(matrix);
+
+    /**
+    best[set] is the best score for the candidates not in the set.
+    given the candidates in the set are ranked ahead of them.
+    the bigger sets are solved first.
+    **/
+    int full = (1 << n) - 1;
+    std::vector<long> best(full + 1, 0);
+    RowSums sums(votes, n);
+    for (int set = full - 1; set >= 0; --set) {
+        long best_score = LONG_MIN;
+        for (int c = 0; c < n; ++c) {
+            int bit = 1 << c;
+            if (set & bit) {
+                continue;
+            }
+            long score = best[set | bit] + sums.get(c, full & ~(set | bit));
+            best_score = std::max(best_score, score);
+        }
+        best[set] = best_score;
+    }
+
+    /**
+    the first candidate that achieves the best score at every step.
+    every step places a candidate. so it can't spin.
+    **/
+    int set = 0;
+    while (set != full) {
+        int which = -1;
+        long which_score = LONG_MIN;
+        for (int c = 0; c < n; ++c) {
+            int bit = 1 << c;
+            if (set & bit) {
+                continue;
+            }
+            long score = best[set | bit] + sums.get(c, full & ~(set | bit));
+            if (which < 0 || score > which_score) {
+                which = c;
+                which_score = score;
+            }
+        }
+        ranking_.push_back(which);
+        set |= 1 << which;
+    }
+    score_ = best[0];
+    ms_ = elapsed_ms(start);
+}
+
+void KemenyYoung::solve_branch_and_bound(
+    const PairwiseMatrix& matrix,
+    int nthreads
+) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    int n = matrix.ncandidates();
+    ranking_.clear();
+    score_ = 0;
+    if (n < 3) {
+        /** nothing to split. **/
+        solve_subsets(matrix);
+        ms_ = elapsed_ms(start);
+        return;
+    }
+    auto votes = get_votes(matrix);
+
+    KemenyShared shared;
+    shared.n_ = n;
+    shared.votes_ = votes.data();
+    shared.larger_.resize(n * n);
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            shared.larger_[a * n + b] = std::max(votes[a * n + b], votes[b * n + a]);
+        }
+    }
+    shared.best_ranking_ = greedy_ranking(votes, n);
+    shared.best_score_ = score_ranking(votes, shared.best_ranking_);
+
+    /** subtrees in the order of the greedy ranking. **/
+    auto& greedy = shared.best_ranking_;
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < n; ++k) {
+            if (i != k) {
+                shared.roots_.push_back(greedy[i]);
+                shared.roots_.push_back(greedy[k]);
+            }
+        }
+    }
+
+    /** every thread has its own search state. **/
+    int nroots = shared.roots_.size() / 2;
+    nthreads = parallel_threads(nthreads, nroots);
+    std::vector<KemenySearch> searches(nthreads, KemenySearch(&shared));
+    parallel_for(nthreads, nroots, [&searches](int thread, int root) {
+        searches[thread].run(root);
+    });
+
+    ranking_ = shared.best_ranking_;
+    score_ = shared.best_score_;
+    ms_ = elapsed_ms(start);
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+kemeny young.
+
+the winning ranking agrees with the most voter preferences.
+the score of a ranking is the sum of votes(a, b)
+for every a ranked ahead of b.
+
+there are n factorial rankings.
+so they're not enumerated.
+
+up to 20 candidates...
+the best ranking of the candidates after a set of candidates
+depends only on the set. not on its order.
+so there are 2^n sub-problems.
+
+more than 20 candidates...
+branch and bound.
+a partial ranking can't score more than its score so far
+plus the larger of votes(a, b) and votes(b, a)
+for every pair of candidates still unranked.
+the subtrees are split between threads.
+
+ties go to the ranking that's first alphabetically by candidate index.
+so the answer doesn't depend on the threads.
+**/
+
+#pragma once
+
+#include "pairwise.h"
+
+#include <vector>
+
+
+class KemenyYoung {
+public:
+    KemenyYoung() = default;
+    KemenyYoung(const KemenyYoung &) = delete;
+    ~KemenyYoung() = default;
+
+    /** the best ranking. best first. **/
+    std::vector<int> ranking_;
+    long score_ = 0;
+
+    /** time to solve. **/
+    double ms_ = 0.0;
+
+    /** picks the method by the number of candidates. **/
+    void solve(const PairwiseMatrix& matrix) noexcept;
+
+    /** dynamic programming over sets of candidates. memory is 2^n. **/
+    void solve_subsets(const PairwiseMatrix& matrix) noexcept;
+
+    /** branch and bound. nthreads 0 is one per core. **/
+    void solve_branch_and_bound(const PairwiseMatrix& matrix, int nthreads = 0) noexcept;
+
+    static constexpr int kMaxSubsetCandidates = 20;
+};
@@ -0,0 +1,21 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+log the details unless the caller is being quiet.
+
+the caller has a quiet_ member.
+it's set when many elections or trials run at once.
+**/
+
+#pragma once
+
+#include <aggiornamento/log.h>
+
+
+#define LOG_DETAILS(...) { \
+    if (quiet_ == false) { \
+        LOG(__VA_ARGS__); \
+    } \
+}
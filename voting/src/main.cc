@@ -6,23 +6,123 @@ Copyright (C) 2012-2020 tim cotter. All rights reserved.
 reverse rank order voting.
 
 from fixed data sets for generated data sets.
+
+voting --export dir
+    writes every compiled in data set to dir/name.ballots.
+voting --file name.ballots
+    runs the fixed data methods on a ballot file.
+voting --all [--threads n]
+    runs the fixed data methods on every data set.
+    logs one table of the winners.
 **/
 
+#include "data.h"
 #include "fixed.h"
 #include "generated.h"
 #include "guthrie.h"
+#include "store.h"
 
 #include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/cmd_line.h>
 #include <aggiornamento/log.h>
 
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+void show_help() noexcept {
+    LOG("Usage: " AGM_TARGET_NAME " [options]");
+    LOG("  --help    -?  show this message");
+    LOG("  --file    -f  run the fixed data methods on a ballot file");
+    LOG("  --export  -x  write the compiled in data sets to ballot files in this directory");
+    LOG("  --all     -a  run the fixed data methods on every data set");
+    LOG("  --threads -j  threads for --all. default is one per core");
+}
+
+bool export_data_sets(
+    const char *dir
+) noexcept {
+    for (auto data_set = g_data_sets; data_set->name_; ++data_set) {
+        std::string filename = dir;
+        filename += "/";
+        filename += data_set->name_;
+        filename += ".ballots";
+        auto ballots = data_set->get_voting_data_();
+        auto candidates = data_set->get_candidates_();
+        auto good = BallotStore::save(filename.c_str(), candidates, ballots);
+        if (good == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 int main(
     int argc, char *argv[]
 ) noexcept {
-    (void) argc;
-    (void) argv;
-
     agm::log::init(AGM_TARGET_NAME ".log", false);
 
+    const char *filename = nullptr;
+    const char *export_dir = nullptr;
+    bool all = false;
+    int nthreads = 0;
+    agm::CmdLineOptions::LongFormat cmd_line_options[] = {
+        {"help",   '?'},
+        {"file",   'f'},
+        {"export", 'x'},
+        {"all",    'a'},
+        {"threads",'j'},
+        {nullptr, 0}
+    };
+    agm::CmdLineOptions clo(argc, argv, "?f:x:aj:", cmd_line_options);
+    while (clo.get()) {
+        switch (clo.option_) {
+        case '?':
+            show_help();
+            return 0;
+
+        case 'f':
+            filename = clo.value_;
+            break;
+
+        case 'x':
+            export_dir = clo.value_;
+            break;
+
+        case 'a':
+            all = true;
+            break;
+
+        case 'j':
+            nthreads = std::atoi(clo.value_);
+            break;
+        }
+    }
+    if (clo.error_) {
+        show_help();
+        return 1;
+    }
+
+    if (export_dir) {
+        auto good = export_data_sets(export_dir);
+        return good ? 0 : 1;
+    }
+
+    if (all) {
+        FixedDataVoting fixed;
+        fixed.run_all(nthreads);
+        return 0;
+    }
+
+    if (filename) {
+        FixedDataVoting fixed;
+        auto good = fixed.run_file(filename);
+        return good ? 0 : 1;
+    }
+
     /*FixedDataVoting fixed;
     fixed.run();*/
 
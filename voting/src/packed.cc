@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+packed weighted ballots.
+
+identical ballots are found by sorting the packed rankings.
+**/
+
+#include "packed.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+#include <algorithm>
+
+
+void PackedBallot::eliminate(
+    int candidate
+) noexcept {
+    int dst = 0;
+    for (int src = 0; src < kMaxChoices; ++src) {
+        int c = choice(src);
+        if (c != candidate) {
+            set_choice(dst++, c);
+        }
+    }
+    for (; dst < kMaxChoices; ++dst) {
+        set_choice(dst, 0);
+    }
+}
+
+PackedBallots pack_ballots(
+    const Ballots& ballots
+) noexcept {
+    PackedBallots packed;
+    packed.reserve(ballots.size());
+    for (auto&& ballot : ballots) {
+        PackedBallot pb;
+        for (int i = 0; i < PackedBallot::kMaxChoices; ++i) {
+            pb.set_choice(i, ballot.choice_[i]);
+        }
+        pb.count_ = 1;
+        packed.push_back(pb);
+    }
+    merge_ballots(packed);
+    return packed;
+}
+
+void merge_ballots(
+    PackedBallots& ballots
+) noexcept {
+    if (ballots.empty()) {
+        return;
+    }
+    auto cmp = [](const PackedBallot& a, const PackedBallot& b) -> bool {
+        return (a.ranking_ < b.ranking_);
+    };
+    std::sort(ballots.begin(), ballots.end(), cmp);
+    int dst = 0;
+    for (int src = 1, n = ballots.size(); src < n; ++src) {
+        if (ballots[src].ranking_ == ballots[dst].ranking_) {
+            ballots[dst].count_ += ballots[src].count_;
+        } else {
+            ballots[++dst] = ballots[src];
+        }
+    }
+    ballots.resize(dst + 1);
+}
+
+int count_ballots(
+    const PackedBallots& ballots
+) noexcept {
+    int count = 0;
+    for (auto&& ballot : ballots) {
+        count += ballot.count_;
+    }
+    return count;
+}
@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+packed weighted ballots.
+
+a Ballot is 6 ints.
+a packed ballot is 6 bytes of one integer.
+choice 0 is the low byte.
+
+real elections have lots of identical ballots.
+identical ballots are collapsed into one ballot with a count.
+tabulating the unique ballots weighted by count
+gives the same totals as tabulating every ballot.
+**/
+
+#pragma once
+
+#include "data.h"
+
+#include <cstdint>
+#include <vector>
+
+
+class PackedBallot {
+public:
+    std::uint64_t ranking_ = 0;
+    int count_ = 0;
+
+    static constexpr int kMaxChoices = sizeof(Ballot::choice_) / sizeof(Ballot::choice_[0]);
+
+    /** choices past the end are 0. **/
+    int choice(int i) const noexcept {
+        if (i >= kMaxChoices) {
+            return 0;
+        }
+        return (ranking_ >> (8 * i)) & 0xFF;
+    }
+
+    void set_choice(int i, int choice) noexcept {
+        int shift = 8 * i;
+        ranking_ &= ~(std::uint64_t(0xFF) << shift);
+        ranking_ |= std::uint64_t(choice & 0xFF) << shift;
+    }
+
+    /** remove the candidate and shift the later choices up. **/
+    void eliminate(int candidate) noexcept;
+};
+using PackedBallots = std::vector<PackedBallot>;
+
+/** pack and collapse identical ballots. **/
+PackedBallots pack_ballots(const Ballots& ballots) noexcept;
+
+/** collapse identical packed ballots. **/
+void merge_ballots(PackedBallots& ballots) noexcept;
+
+/** the total number of ballots. **/
+int count_ballots(const PackedBallots& ballots) noexcept;
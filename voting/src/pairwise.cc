@@ -0,0 +1,211 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+pairwise preferences.
+
+the inner loop compares one rank to a row of ranks.
+it has no branches so the compiler vectorizes it.
+**/
+
+#include "pairwise.h"
+#include "parallel.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+#include <algorithm>
+
+
+namespace {
+    /** not worth starting threads for small elections. **/
+    const long kMinWorkPerThread = 4L * 1024 * 1024;
+
+    void count_ballots(
+        const int *ranks,
+        const int *weights,
+        int first,
+        int last,
+        int ncandidates,
+        int *votes
+    ) noexcept {
+        for (int i = first; i < last; ++i) {
+            auto r = &ranks[i * ncandidates];
+            int weight = weights[i];
+            for (int a = 0; a < ncandidates; ++a) {
+                int ra = r[a];
+                auto row = &votes[a * ncandidates];
+                for (int b = 0; b < ncandidates; ++b) {
+                    row[b] += (ra < r[b]) ? weight : 0;
+                }
+            }
+        }
+    }
+}
+
+void PairwiseMatrix::init(
+    const std::vector<int>& ranks,
+    const std::vector<int>& weights,
+    int ncandidates
+) noexcept {
+    ncandidates_ = ncandidates;
+    int nsquared = ncandidates * ncandidates;
+    votes_.assign(nsquared, 0);
+    int nballots = weights.size();
+    if (nballots == 0 || ncandidates == 0) {
+        return;
+    }
+
+    long work = long(nballots) * long(nsquared);
+    long max_threads = std::min(work / kMinWorkPerThread, long(kMaxParallelThreads));
+    int nthreads = parallel_threads(0, max_threads);
+    if (nthreads == 1) {
+        count_ballots(ranks.data(), weights.data(), 0, nballots, ncandidates, votes_.data());
+        return;
+    }
+
+    /** one chunk per thread. the first chunk is counted into votes_. **/
+    std::vector<int> partial((nthreads - 1) * nsquared, 0);
+    int chunk = (nballots + nthreads - 1) / nthreads;
+    parallel_for(nthreads, nthreads, [&](int, int i) {
+        int first = std::min(i * chunk, nballots);
+        int last = std::min(first + chunk, nballots);
+        auto votes = (i == 0) ? votes_.data() : &partial[(i - 1) * nsquared];
+        count_ballots(ranks.data(), weights.data(), first, last, ncandidates, votes);
+    });
+
+    for (int i = 1; i < nthreads; ++i) {
+        auto votes = &partial[(i - 1) * nsquared];
+        for (int k = 0; k < nsquared; ++k) {
+            votes_[k] += votes[k];
+        }
+    }
+}
+
+int PairwiseMatrix::schulze_winner() const noexcept {
+    int n = ncandidates_;
+    if (n == 0) {
+        return -1;
+    }
+
+    /** the direct paths are the victories. **/
+    std::vector<int> strength(n * n, 0);
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            if (beats(a, b)) {
+                strength[a * n + b] = votes(a, b);
+            }
+        }
+    }
+
+    /** widest paths. floyd warshall. **/
+    for (int k = 0; k < n; ++k) {
+        for (int a = 0; a < n; ++a) {
+            if (a == k) {
+                continue;
+            }
+            int ak = strength[a * n + k];
+            if (ak == 0) {
+                continue;
+            }
+            for (int b = 0; b < n; ++b) {
+                if (b == a || b == k) {
+                    continue;
+                }
+                int path = std::min(ak, strength[k * n + b]);
+                auto& ab = strength[a * n + b];
+                ab = std::max(ab, path);
+            }
+        }
+    }
+
+    for (int a = 0; a < n; ++a) {
+        bool is_winner = true;
+        for (int b = 0; b < n; ++b) {
+            if (strength[b * n + a] > strength[a * n + b]) {
+                is_winner = false;
+                break;
+            }
+        }
+        if (is_winner) {
+            return a;
+        }
+    }
+    return -1;
+}
+
+int PairwiseMatrix::ranked_pairs_winner() const noexcept {
+    int n = ncandidates_;
+    if (n == 0) {
+        return -1;
+    }
+
+    class Pair {
+    public:
+        int winner_;
+        int loser_;
+        int for_;
+        int against_;
+    };
+    std::vector<Pair> pairs;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            if (beats(a, b)) {
+                pairs.push_back({a, b, votes(a, b), votes(b, a)});
+            }
+        }
+    }
+
+    /** strongest victory first. the smaller minority breaks ties. **/
+    auto cmp = [](const Pair& x, const Pair& y) -> bool {
+        if (x.for_ != y.for_) {
+            return (x.for_ > y.for_);
+        }
+        return (x.against_ < y.against_);
+    };
+    std::stable_sort(pairs.begin(), pairs.end(), cmp);
+
+    std::vector<char> locked(n * n, 0);
+    std::vector<int> stack;
+    std::vector<char> seen(n);
+    for (auto&& pair : pairs) {
+        /** a cycle if the loser already reaches the winner. **/
+        seen.assign(n, 0);
+        stack.clear();
+        stack.push_back(pair.loser_);
+        seen[pair.loser_] = 1;
+        bool cycle = false;
+        while (stack.empty() == false && cycle == false) {
+            int from = stack.back();
+            stack.pop_back();
+            for (int to = 0; to < n; ++to) {
+                if (locked[from * n + to] == 0 || seen[to]) {
+                    continue;
+                }
+                if (to == pair.winner_) {
+                    cycle = true;
+                    break;
+                }
+                seen[to] = 1;
+                stack.push_back(to);
+            }
+        }
+        if (cycle == false) {
+            locked[pair.winner_ * n + pair.loser_] = 1;
+        }
+    }
+
+    for (int b = 0; b < n; ++b) {
+        bool is_winner = true;
+        for (int a = 0; a < n; ++a) {
+            if (locked[a * n + b]) {
+                is_winner = false;
+                break;
+            }
+        }
+        if (is_winner) {
+            return b;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+pairwise preferences.
+
+votes(a, b) is the number of voters who prefer a over b.
+it's built in one pass over the ballots.
+every condorcet method only needs the matrix.
+so they cost candidates cubed no matter how many ballots.
+
+ballots are given as ranks.
+the rank of every candidate on the ballot. lower is better.
+unranked candidates share the last rank.
+voters don't prefer either of two candidates with the same rank.
+
+big elections split the ballots between threads.
+each thread counts its own matrix.
+the matrices are summed.
+**/
+
+#pragma once
+
+#include <vector>
+
+
+class PairwiseMatrix {
+public:
+    PairwiseMatrix() = default;
+    PairwiseMatrix(const PairwiseMatrix &) = delete;
+    ~PairwiseMatrix() = default;
+
+    /**
+    ranks has ncandidates per ballot.
+    weights has one per ballot.
+    **/
+    void init(const std::vector<int>& ranks, const std::vector<int>& weights, int ncandidates) noexcept;
+
+    int ncandidates() const noexcept { return ncandidates_; }
+
+    /** voters who prefer a over b. **/
+    int votes(int a, int b) const noexcept { return votes_[a * ncandidates_ + b]; }
+
+    bool beats(int a, int b) const noexcept { return votes(a, b) > votes(b, a); }
+
+    /**
+    strongest beatpath.
+    the winner's strongest path to every other candidate
+    is at least as strong as the path back.
+    there is always a winner.
+    ties go to the first candidate.
+    **/
+    int schulze_winner() const noexcept;
+
+    /**
+    tideman.
+    lock in the victories from strongest to weakest.
+    skip any victory that would make a cycle.
+    the winner is never beaten by a locked victory.
+    ties go to the first pair.
+    **/
+    int ranked_pairs_winner() const noexcept;
+
+private:
+    int ncandidates_ = 0;
+    std::vector<int> votes_;
+};
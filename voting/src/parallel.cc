@@ -0,0 +1,101 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+run a loop on many threads.
+**/
+
+#include "parallel.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace {
+    /** the items and the next one to do. **/
+    class ParallelShared {
+    public:
+        int count_ = 0;
+        std::atomic<int> next_{0};
+        const std::function<void(int thread, int i)> *fn_ = nullptr;
+
+        /** take items until there are none left. **/
+        void run(
+            int thread
+        ) noexcept {
+            for(;;) {
+                int i = next_.fetch_add(1);
+                if (i >= count_) {
+                    break;
+                }
+                (*fn_)(thread, i);
+            }
+        }
+    };
+
+    class ParallelWorker : public agm::Thread {
+    public:
+        ParallelWorker(
+            ParallelShared *shared,
+            int thread
+        ) noexcept :
+            agm::Thread("ParallelWorker"),
+            shared_(shared),
+            thread_(thread) {
+        }
+
+        virtual ~ParallelWorker() = default;
+
+        ParallelShared *shared_;
+        int thread_;
+
+        /** items then done. **/
+        virtual void run() noexcept {
+            shared_->run(thread_);
+        }
+    };
+}
+
+int parallel_threads(
+    int nthreads,
+    int count
+) noexcept {
+    if (nthreads <= 0) {
+        nthreads = std::thread::hardware_concurrency();
+        nthreads = std::min(nthreads, kMaxParallelThreads);
+    }
+    nthreads = std::min(nthreads, count);
+    nthreads = std::max(nthreads, 1);
+    return nthreads;
+}
+
+void parallel_for(
+    int nthreads,
+    int count,
+    const std::function<void(int thread, int i)>& fn
+) noexcept {
+    ParallelShared shared;
+    shared.count_ = count;
+    shared.fn_ = &fn;
+
+    nthreads = parallel_threads(nthreads, count);
+    if (nthreads == 1) {
+        shared.run(0);
+        return;
+    }
+
+    std::vector<agm::Thread *> threads;
+    std::vector<agm::Container *> containers;
+    for (int i = 1; i < nthreads; ++i) {
+        threads.push_back(new(std::nothrow) ParallelWorker(&shared, i));
+    }
+    agm::Thread::startAll(threads, containers);
+    shared.run(0);
+    agm::Thread::stopAll(threads, containers);
+}
@@ -0,0 +1,37 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+run a loop on many threads.
+
+the items are handed out in order from a shared counter.
+so the threads balance themselves.
+the master thread takes items too.
+so n threads is n-1 workers.
+
+the function is told which thread is calling.
+so each thread can keep its own state.
+thread 0 is the master thread.
+**/
+
+#pragma once
+
+#include <functional>
+
+
+/** more threads than this don't help. **/
+const int kMaxParallelThreads = 8;
+
+/**
+0 is one per core up to kMaxParallelThreads.
+other values are taken as is.
+never more than the number of items. never less than 1.
+**/
+int parallel_threads(int nthreads, int count) noexcept;
+
+/**
+calls fn(thread, i) for every i in 0..count-1.
+returns when every item is done.
+**/
+void parallel_for(int nthreads, int count, const std::function<void(int thread, int i)>& fn) noexcept;
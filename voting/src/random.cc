@@ -3,12 +3,34 @@ Copyright (C) 2012-2025 tim cotter. All rights reserved.
 */
 
 /**
-wraopper class for c++ random number generator.
+xoshiro256** random number generator.
 
 some methods:
 uniform double from 0.0 to 1.0-.
 int from 0 to N-1
 normal distribution with mean 0.0 standard deviation 1.0.
+
+the state is seeded with splitmix64.
+the stream is mixed into the seed.
+streams could jump instead.
+but a jump costs 256 numbers and trial n would need n jumps.
+
+the lanes are seeded from the same splitmix64 sequence after the state.
+
+uniforms from the lanes use the top 52 bits as the mantissa of 1.0 to 2.0-.
+then subtract 1.0.
+there's no simd conversion from 64 bit int to double without avx512.
+this way the whole fill is sse2.
+sse2 is every x64 cpu.
+other cpus get the same numbers one lane at a time.
+
+normals use the box muller transform.
+the arrays of normals are filled with uniforms from the lanes first.
+then transformed in place.
+the transform has no branches.
+but it stays scalar.
+gcc only calls the vector log sin cos from libmvec with -ffast-math.
+and we don't build with that.
 **/
 
 #include "random.h"
@@ -16,77 +38,244 @@ normal distribution with mean 0.0 standard deviation 1.0.
 #include <aggiornamento/aggiornamento.h>
 #include <aggiornamento/log.h>
 
+#include <bit>
 #include <chrono>
-#include <random>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 
 namespace {
 
-class RngImpl {
-public:
-    std::uint64_t seed_ = 0;
-    std::mt19937_64 rng_;
-    std::uniform_real_distribution<double> unif_;
-    std::normal_distribution<double> norm_;
-
-    void init(
-        std::uint64_t seed
-    ) noexcept {
-        if (seed == 0) {
-            seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        }
-        seed_ = seed;
-        std::seed_seq ss{uint32_t(seed & 0xffffffff), uint32_t(seed>>32)};
-        rng_.seed(ss);
-        unif_ = std::uniform_real_distribution<double>(0.0, 1.0);
-        norm_ = std::normal_distribution<double>(0.0, 1.0);
-    }
+std::uint64_t splitmix64(
+    std::uint64_t& x
+) noexcept {
+    x += 0x9E3779B97F4A7C15ULL;
+    std::uint64_t z = x;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-    std::uint64_t get_seed() noexcept {
-        return seed_;
-    }
+/** two uniforms to two normals. u1 must not be 0. **/
+inline void box_muller(
+    double u1,
+    double u2,
+    double& n1,
+    double& n2
+) noexcept {
+    double r = std::sqrt(-2.0 * std::log(u1));
+    double theta = 2.0 * std::numbers::pi * u2;
+    n1 = r * std::cos(theta);
+    n2 = r * std::sin(theta);
+}
 
-    double generate() noexcept {
-        double x = unif_(rng_);
-        return x;
-    }
+const std::uint64_t kOne = 0x3FF0000000000000ULL;
+
+typedef std::uint64_t Lanes[RandomNumberGenerator::kLanes];
+
+#if defined(__SSE2__) || defined(_M_X64)
 
-    int generate(int max) noexcept {
-        double x = generate();
-        int i = std::floor(x * double(max));
-        return i;
+/** sse2 has no 64 bit multiply or rotate. **/
+template<int k>
+inline __m128i rotl2(
+    __m128i x
+) noexcept {
+    return _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - k));
+}
+
+/** two lanes at once. **/
+inline __m128d next2(
+    __m128i& s0,
+    __m128i& s1,
+    __m128i& s2,
+    __m128i& s3
+) noexcept {
+    __m128i x5 = _mm_add_epi64(s1, _mm_slli_epi64(s1, 2));
+    __m128i r = rotl2<7>(x5);
+    __m128i result = _mm_add_epi64(r, _mm_slli_epi64(r, 3));
+    __m128i t = _mm_slli_epi64(s1, 17);
+    s2 = _mm_xor_si128(s2, s0);
+    s3 = _mm_xor_si128(s3, s1);
+    s1 = _mm_xor_si128(s1, s2);
+    s0 = _mm_xor_si128(s0, s3);
+    s2 = _mm_xor_si128(s2, t);
+    s3 = rotl2<45>(s3);
+    __m128i bits = _mm_or_si128(_mm_srli_epi64(result, 12), _mm_set1_epi64x(kOne));
+    return _mm_sub_pd(_mm_castsi128_pd(bits), _mm_set1_pd(1.0));
+}
+
+/**
+fill whole groups of kLanes.
+returns how many were filled.
+**/
+int fill_lanes(
+    Lanes *lanes,
+    double *values,
+    int count
+) noexcept {
+    static_assert(RandomNumberGenerator::kLanes == 4);
+    __m128i s[4][2];
+    for (int w = 0; w < 4; ++w) {
+        s[w][0] = _mm_loadu_si128((const __m128i *) &lanes[w][0]);
+        s[w][1] = _mm_loadu_si128((const __m128i *) &lanes[w][2]);
+    }
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_pd(values + i, next2(s[0][0], s[1][0], s[2][0], s[3][0]));
+        _mm_storeu_pd(values + i + 2, next2(s[0][1], s[1][1], s[2][1], s[3][1]));
+    }
+    for (int w = 0; w < 4; ++w) {
+        _mm_storeu_si128((__m128i *) &lanes[w][0], s[w][0]);
+        _mm_storeu_si128((__m128i *) &lanes[w][2], s[w][1]);
     }
+    return i;
+}
+
+#else
 
-    double normal() noexcept {
-        double x = norm_(rng_);
-        return x;
+inline std::uint64_t rotl(
+    std::uint64_t x,
+    int k
+) noexcept {
+    return (x << k) | (x >> (64 - k));
+}
+
+/** same numbers as the sse2 version. one lane at a time. **/
+int fill_lanes(
+    Lanes *lanes,
+    double *values,
+    int count
+) noexcept {
+    const int kLanes = RandomNumberGenerator::kLanes;
+    int i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        for (int k = 0; k < kLanes; ++k) {
+            std::uint64_t *s0 = &lanes[0][k];
+            std::uint64_t *s1 = &lanes[1][k];
+            std::uint64_t *s2 = &lanes[2][k];
+            std::uint64_t *s3 = &lanes[3][k];
+            std::uint64_t result = rotl(*s1 * 5, 7) * 9;
+            std::uint64_t t = *s1 << 17;
+            *s2 ^= *s0;
+            *s3 ^= *s1;
+            *s1 ^= *s2;
+            *s0 ^= *s3;
+            *s2 ^= t;
+            *s3 = rotl(*s3, 45);
+            std::uint64_t bits = (result >> 12) | kOne;
+            values[i + k] = std::bit_cast<double>(bits) - 1.0;
+        }
     }
-};
+    return i;
+}
 
-static RngImpl *impl_ = nullptr;
+#endif
 
 } // namespace
 
+std::uint64_t RandomNumberGenerator::make_seed() noexcept {
+    return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+
 void RandomNumberGenerator::init(
-    std::uint64_t seed
+    std::uint64_t seed,
+    std::uint64_t stream
 ) noexcept {
-    delete impl_;
-    impl_ = new(std::nothrow) RngImpl();
-    impl_->init(seed);
+    if (seed == 0) {
+        seed = make_seed();
+    }
+    seed_ = seed;
+    std::uint64_t x = seed;
+    std::uint64_t mixed = splitmix64(x) ^ stream;
+    x = mixed;
+    for (int i = 0; i < 4; ++i) {
+        state_[i] = splitmix64(x);
+    }
+    for (int k = 0; k < kLanes; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            lanes_[i][k] = splitmix64(x);
+        }
+    }
+    has_spare_ = false;
+}
+
+void RandomNumberGenerator::jump() noexcept {
+    jump(state_);
+    for (int k = 0; k < kLanes; ++k) {
+        std::uint64_t lane[4];
+        for (int i = 0; i < 4; ++i) {
+            lane[i] = lanes_[i][k];
+        }
+        jump(lane);
+        for (int i = 0; i < 4; ++i) {
+            lanes_[i][k] = lane[i];
+        }
+    }
+    has_spare_ = false;
 }
 
-std::uint64_t RandomNumberGenerator::get_seed() noexcept {
-    return impl_->get_seed();
+void RandomNumberGenerator::jump(
+    std::uint64_t *state
+) noexcept {
+    static const std::uint64_t kJump[] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    std::uint64_t s[4] = {0, 0, 0, 0};
+    for (auto jump : kJump) {
+        for (int b = 0; b < 64; ++b) {
+            if (jump & (std::uint64_t(1) << b)) {
+                for (int i = 0; i < 4; ++i) {
+                    s[i] ^= state[i];
+                }
+            }
+            next(state);
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        state[i] = s[i];
+    }
 }
 
-double RandomNumberGenerator::generate() noexcept {
-    return impl_->generate();
+double RandomNumberGenerator::normal() noexcept {
+    if (has_spare_) {
+        has_spare_ = false;
+        return spare_;
+    }
+    double u1 = 1.0 - generate();
+    double u2 = generate();
+    double n1;
+    box_muller(u1, u2, n1, spare_);
+    has_spare_ = true;
+    return n1;
 }
 
-int RandomNumberGenerator::generate(int max) noexcept {
-    return impl_->generate(max);
+void RandomNumberGenerator::generate(
+    double *values,
+    int count
+) noexcept {
+    int i = fill_lanes(lanes_, values, count);
+    for (; i < count; ++i) {
+        values[i] = generate();
+    }
 }
 
-double RandomNumberGenerator::normal() noexcept {
-    return impl_->normal();
+void RandomNumberGenerator::normal(
+    double *values,
+    int count
+) noexcept {
+    int npairs = count / 2;
+    generate(values, 2 * npairs);
+    for (int i = 0; i < npairs; ++i) {
+        double u1 = 1.0 - values[2*i];
+        double u2 = values[2*i+1];
+        box_muller(u1, u2, values[2*i], values[2*i+1]);
+    }
+    if (count & 1) {
+        values[count - 1] = normal();
+    }
 }
@@ -3,7 +3,20 @@ Copyright (C) 2012-2025 tim cotter. All rights reserved.
 */
 
 /**
-wraopper class for c++ random number generator.
+xoshiro256** random number generator.
+
+every trial has its own generator.
+the numbers depend only on the seed and the stream.
+so trials can run in any order on any thread.
+
+the state is 4 words.
+the generator is inline so a number costs a few instructions.
+
+the arrays are filled by kLanes more generators side by side.
+each step is the same instructions on every lane.
+so the lanes step together in simd registers.
+the arrays are a different sequence than calling generate.
+but they still depend only on the seed and the stream.
 **/
 
 #pragma once
@@ -13,23 +26,81 @@ wraopper class for c++ random number generator.
 
 class RandomNumberGenerator {
 public:
+    RandomNumberGenerator() = default;
+    RandomNumberGenerator(const RandomNumberGenerator &) = default;
+    ~RandomNumberGenerator() = default;
+
+    /** a seed from the clock. **/
+    static std::uint64_t make_seed() noexcept;
+
     /**
     must be called first.
-    use a randomly generated seed if the parameter is 0.
+    use a randomly generated seed if the seed is 0.
+    different streams of the same seed are independent.
+    **/
+    void init(std::uint64_t seed, std::uint64_t stream = 0) noexcept;
+
+    /**
+    skip 2^128 numbers.
+    copies of one generator jumped 0, 1, 2... times never overlap.
     **/
-    static void init(std::uint64_t seed) noexcept;
+    void jump() noexcept;
 
     /** exposed so cases can be reproduced. **/
-    static std::uint64_t get_seed() noexcept;
+    std::uint64_t get_seed() const noexcept { return seed_; }
+
+    /** 64 random bits. **/
+    std::uint64_t next() noexcept {
+        return next(state_);
+    }
 
     /** uniform from 0.0 to 1.0-. **/
-    static double generate() noexcept;
+    double generate() noexcept {
+        return double(next() >> 11) * 0x1.0p-53;
+    }
 
     /** uniform from 0 to max-1 **/
-    static int generate(int max) noexcept;
+    int generate(int max) noexcept {
+        return int(generate() * double(max));
+    }
 
     /** normal distribritution with mean 0.0 and standard deviation 1.0. **/
-    static double normal() noexcept;
+    double normal() noexcept;
+
+    /** fill an array with uniforms from the lanes. **/
+    void generate(double *values, int count) noexcept;
+
+    /** fill an array with normals. **/
+    void normal(double *values, int count) noexcept;
+
+    static constexpr int kLanes = 4;
+
+private:
+    std::uint64_t seed_ = 0;
+    std::uint64_t state_[4] = {1, 2, 3, 4};
+    /** word w of lane i is lanes_[w][i]. **/
+    std::uint64_t lanes_[4][kLanes] = {};
+    /** box muller makes normals in pairs. **/
+    bool has_spare_ = false;
+    double spare_ = 0.0;
+
+    static std::uint64_t rotl(std::uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t next(std::uint64_t *s) noexcept {
+        std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    static void jump(std::uint64_t *s) noexcept;
 };
 
 typedef RandomNumberGenerator Rng;
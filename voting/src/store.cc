@@ -0,0 +1,337 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+binary ballot files.
+
+the header is 32 bytes.
+the names are padded to 4 bytes so the weights are aligned.
+the rankings are 1 byte per choice.
+so there can't be more than 256 candidates.
+
+the file may come from anywhere.
+so every name and every ranking is checked when it's loaded.
+
+the file is written to a temporary file and renamed.
+so nobody ever maps half a file.
+**/
+
+#include "store.h"
+
+#include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/log.h>
+
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+const char kMagic[8] = {'B', 'A', 'L', 'L', 'O', 'T', 'S', 0};
+/** change this when the format changes. **/
+const std::uint32_t kVersion = 1;
+const std::uint32_t kFlagWeights = 1;
+const int kMaxChoices = sizeof(Ballot::choice_) / sizeof(Ballot::choice_[0]);
+
+class Header {
+public:
+    char magic_[8];
+    std::uint32_t version_;
+    std::uint32_t flags_;
+    std::uint32_t ncandidates_;
+    std::uint32_t nchoices_;
+    std::uint32_t nballots_;
+    std::uint32_t names_bytes_;
+};
+static_assert(sizeof(Header) == 32, "the header is 32 bytes.");
+
+std::size_t pad4(
+    std::size_t bytes
+) noexcept {
+    return (bytes + 3) & ~std::size_t(3);
+}
+
+std::size_t file_length(
+    const Header& header
+) noexcept {
+    std::size_t length = sizeof(Header) + pad4(header.names_bytes_);
+    if (header.flags_ & kFlagWeights) {
+        length += sizeof(std::uint32_t) * header.nballots_;
+    }
+    length += std::size_t(header.nballots_) * header.nchoices_;
+    return length;
+}
+
+} // namespace
+
+BallotStore::BallotStore() noexcept {
+}
+
+BallotStore::~BallotStore() noexcept {
+    exit();
+}
+
+bool BallotStore::load(
+    const char *filename
+) noexcept {
+    exit();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        LOG("Ballot file not found: "<<filename);
+        return false;
+    }
+    struct stat info;
+    int result = fstat(fd, &info);
+    std::size_t length = info.st_size;
+    if (result < 0 || length < sizeof(Header)) {
+        LOG("Ballot file is too short: "<<filename);
+        close(fd);
+        return false;
+    }
+    auto map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    /** the map keeps the file open. **/
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOG("Failed to map ballot file: "<<filename);
+        return false;
+    }
+
+    map_ = map;
+    length_ = length;
+    auto header = (const Header *) map;
+    if (std::memcmp(header->magic_, kMagic, sizeof(kMagic)) != 0) {
+        LOG("Not a ballot file: "<<filename);
+        exit();
+        return false;
+    }
+    if (header->version_ != kVersion) {
+        LOG("Wrong version ballot file: "<<filename<<" version="<<header->version_);
+        exit();
+        return false;
+    }
+    if (header->nchoices_ > std::uint32_t(kMaxChoices)) {
+        LOG("Too many choices in ballot file: "<<filename<<" nchoices="<<header->nchoices_);
+        exit();
+        return false;
+    }
+    if (header->ncandidates_ > 256) {
+        LOG("Too many candidates in ballot file: "<<filename<<" ncandidates="<<header->ncandidates_);
+        exit();
+        return false;
+    }
+    if (header->nballots_ > std::uint32_t(INT_MAX)) {
+        LOG("Too many ballots in ballot file: "<<filename<<" nballots="<<header->nballots_);
+        exit();
+        return false;
+    }
+    if (file_length(*header) != length) {
+        LOG("Wrong length ballot file: "<<filename<<" length="<<length);
+        exit();
+        return false;
+    }
+
+    nballots_ = header->nballots_;
+    nchoices_ = header->nchoices_;
+    int ncandidates = header->ncandidates_;
+
+    /** every name must be terminated inside the name table. **/
+    auto ptr = (const char *) map + sizeof(Header);
+    auto end = ptr + header->names_bytes_;
+    while (int(candidates_.size()) < ncandidates && ptr < end) {
+        auto len = strnlen(ptr, end - ptr);
+        if (ptr + len == end) {
+            break;
+        }
+        candidates_.push_back(ptr);
+        ptr += len + 1;
+    }
+    if (int(candidates_.size()) != ncandidates) {
+        LOG("Ballot file has "<<candidates_.size()<<" names for "<<ncandidates<<" candidates: "<<filename);
+        exit();
+        return false;
+    }
+
+    ptr = (const char *) map + sizeof(Header) + pad4(header->names_bytes_);
+    if (header->flags_ & kFlagWeights) {
+        weights_ = (const std::uint32_t *) ptr;
+        ptr += sizeof(std::uint32_t) * nballots_;
+    }
+    rankings_ = (const std::uint8_t *) ptr;
+
+    /** the weights and the total number of ballots must fit in an int. **/
+    if (weights_) {
+        std::int64_t total = 0;
+        for (int i = 0; i < nballots_; ++i) {
+            std::uint32_t weight = weights_[i];
+            if (weight == 0 || weight > std::uint32_t(INT_MAX)) {
+                LOG("Invalid weight in ballot file: "<<filename<<" ballot="<<i<<" weight="<<weight);
+                exit();
+                return false;
+            }
+            total += weight;
+        }
+        if (total > INT_MAX) {
+            LOG("Too many weighted ballots in ballot file: "<<filename<<" total="<<total);
+            exit();
+            return false;
+        }
+    }
+
+    /** the rankings index the candidates. **/
+    std::size_t nrankings = std::size_t(nballots_) * nchoices_;
+    for (std::size_t i = 0; i < nrankings; ++i) {
+        if (rankings_[i] >= ncandidates) {
+            LOG("Invalid choice in ballot file: "<<filename<<" ballot="<<i / nchoices_<<" choice="<<int(rankings_[i]));
+            exit();
+            return false;
+        }
+    }
+
+    LOG("Mapped "<<nballots_<<" ballots for "<<candidates_.size()<<" candidates from "<<filename);
+    return true;
+}
+
+void BallotStore::exit() noexcept {
+    if (map_) {
+        munmap(map_, length_);
+        map_ = nullptr;
+        length_ = 0;
+    }
+    nballots_ = 0;
+    nchoices_ = 0;
+    candidates_.clear();
+    weights_ = nullptr;
+    rankings_ = nullptr;
+}
+
+bool BallotStore::save(
+    const char *filename,
+    const Candidates& candidates,
+    const Ballots& ballots
+) noexcept {
+    int ncandidates = candidates.size();
+    if (ncandidates > 256) {
+        LOG("Too many candidates for a ballot file: "<<ncandidates);
+        return false;
+    }
+    /** every choice. so the file is lossless. **/
+    int nchoices = kMaxChoices;
+
+    /** collapse identical ballots. keep the order they first appear. **/
+    using Ranking = std::array<std::uint8_t, kMaxChoices>;
+    std::map<Ranking, int> index;
+    std::vector<Ranking> rankings;
+    std::vector<std::uint32_t> weights;
+    for (auto&& ballot : ballots) {
+        Ranking ranking{};
+        for (int i = 0; i < nchoices; ++i) {
+            int choice = ballot.choice_[i];
+            if (choice < 0 || choice >= ncandidates) {
+                LOG("Invalid choice on a ballot: "<<choice);
+                return false;
+            }
+            ranking[i] = choice;
+        }
+        auto it = index.find(ranking);
+        if (it == index.end()) {
+            index[ranking] = rankings.size();
+            rankings.push_back(ranking);
+            weights.push_back(1);
+        } else {
+            ++weights[it->second];
+        }
+    }
+    bool has_weights = (rankings.size() < ballots.size());
+
+    std::string names;
+    for (auto&& name : candidates) {
+        names += name;
+        names += '\0';
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, kMagic, sizeof(kMagic));
+    header.version_ = kVersion;
+    header.flags_ = has_weights ? kFlagWeights : 0;
+    header.ncandidates_ = ncandidates;
+    header.nchoices_ = nchoices;
+    header.nballots_ = rankings.size();
+    header.names_bytes_ = names.size();
+    names.resize(pad4(names.size()), '\0');
+
+    std::string temp = filename;
+    temp += ".tmp";
+    auto fp = std::fopen(temp.c_str(), "wb");
+    if (fp == nullptr) {
+        LOG("Failed to create: "<<temp);
+        return false;
+    }
+    bool good = (std::fwrite(&header, sizeof(header), 1, fp) == 1);
+    good = good && (std::fwrite(names.data(), names.size(), 1, fp) == 1);
+    if (has_weights) {
+        good = good && (std::fwrite(weights.data(), sizeof(std::uint32_t), weights.size(), fp) == weights.size());
+    }
+    for (auto&& ranking : rankings) {
+        good = good && (std::fwrite(ranking.data(), nchoices, 1, fp) == 1);
+    }
+    good = (std::fclose(fp) == 0) && good;
+    if (good) {
+        good = (std::rename(temp.c_str(), filename) == 0);
+    }
+    if (good == false) {
+        LOG("Failed to write: "<<filename);
+        std::remove(temp.c_str());
+        return false;
+    }
+    LOG("Saved "<<ballots.size()<<" ballots as "<<rankings.size()<<" unique ballots to "<<filename);
+    return true;
+}
+
+Candidates BallotStore::get_candidates() const noexcept {
+    return candidates_;
+}
+
+Ballots BallotStore::get_voting_data() const noexcept {
+    Ballots ballots;
+    Ballot ballot;
+    for (int i = 0; i < nballots_; ++i) {
+        auto ranking = this->ranking(i);
+        for (int k = 0; k < kMaxChoices; ++k) {
+            ballot.choice_[k] = (k < nchoices_) ? ranking[k] : 0;
+        }
+        int count = weight(i);
+        for (int k = 0; k < count; ++k) {
+            ballots.push_back(ballot);
+        }
+    }
+    return ballots;
+}
+
+PackedBallots BallotStore::get_packed_ballots() const noexcept {
+    PackedBallots ballots;
+    ballots.reserve(nballots_);
+    for (int i = 0; i < nballots_; ++i) {
+        auto ranking = this->ranking(i);
+        PackedBallot ballot;
+        for (int k = 0; k < nchoices_; ++k) {
+            ballot.set_choice(k, ranking[k]);
+        }
+        ballot.count_ = weight(i);
+        ballots.push_back(ballot);
+    }
+    merge_ballots(ballots);
+    return ballots;
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+binary ballot files.
+
+the fixed data sets are c++ initializer lists.
+they take a long time to compile.
+a ballot file holds the same data.
+elections can be added without recompiling.
+
+the file is mapped read only.
+loading a million ballots takes a few milliseconds.
+
+the file:
+    header
+    candidate names. nul terminated.
+    weights. optional. 32 bits per ballot.
+    rankings. one byte per choice.
+
+identical ballots are stored once with a weight.
+**/
+
+#pragma once
+
+#include "data.h"
+#include "packed.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+class BallotStore {
+public:
+    BallotStore() noexcept;
+    BallotStore(const BallotStore &) = delete;
+    ~BallotStore() noexcept;
+
+    /** map the file. returns false if it's missing or the wrong version. **/
+    bool load(const char *filename) noexcept;
+
+    /** unmap the file. **/
+    void exit() noexcept;
+
+    /** write a ballot file. identical ballots become one weighted ballot. **/
+    static bool save(const char *filename, const Candidates& candidates, const Ballots& ballots) noexcept;
+
+    /** same as the fixed data sets. **/
+    Candidates get_candidates() const noexcept;
+
+    /** same as the fixed data sets. weighted ballots are repeated. **/
+    Ballots get_voting_data() const noexcept;
+
+    /** the weighted ballots without repeating them. **/
+    PackedBallots get_packed_ballots() const noexcept;
+
+    /** direct access to the mapped ballots. **/
+    int nballots() const noexcept { return nballots_; }
+    int nchoices() const noexcept { return nchoices_; }
+    const std::uint8_t *ranking(int i) const noexcept { return &rankings_[i * nchoices_]; }
+    int weight(int i) const noexcept { return weights_ ? weights_[i] : 1; }
+
+private:
+    void *map_ = nullptr;
+    std::size_t length_ = 0;
+    int nballots_ = 0;
+    int nchoices_ = 0;
+    Candidates candidates_;
+    const std::uint32_t *weights_ = nullptr;
+    const std::uint8_t *rankings_ = nullptr;
+};
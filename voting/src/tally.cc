@@ -0,0 +1,76 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+ranked ballots without rewriting them.
+**/
+
+#include "tally.h"
+
+#include <aggiornamento/aggiornamento.h>
+
+
+void RankedTally::init(
+    const PackedBallots& ballots,
+    int ncandidates
+) noexcept {
+    ballots_ = &ballots;
+    int nballots = ballots.size();
+    cursor_.assign(nballots, 0);
+    piles_.assign(ncandidates, std::vector<int>());
+    counts_.assign(ncandidates, 0);
+    in_race_.assign(ncandidates, 1);
+    /** n/a is never in the race. **/
+    in_race_[0] = 0;
+    for (int i = 0; i < nballots; ++i) {
+        advance(i);
+    }
+}
+
+void RankedTally::eliminate(
+    int candidate
+) noexcept {
+    in_race_[candidate] = 0;
+    auto pile = std::move(piles_[candidate]);
+    piles_[candidate].clear();
+    counts_[candidate] = 0;
+    for (auto i : pile) {
+        advance(i);
+    }
+}
+
+void RankedTally::get_choices(
+    int ballot,
+    int *choices
+) const noexcept {
+    auto& b = (*ballots_)[ballot];
+    int dst = 0;
+    for (int src = 0; src < PackedBallot::kMaxChoices; ++src) {
+        int choice = b.choice(src);
+        if (choice == 0 || in_race_[choice]) {
+            choices[dst++] = choice;
+        }
+    }
+    for (; dst < PackedBallot::kMaxChoices; ++dst) {
+        choices[dst] = 0;
+    }
+}
+
+void RankedTally::advance(
+    int ballot
+) noexcept {
+    auto& b = (*ballots_)[ballot];
+    int cursor = cursor_[ballot];
+    int choice = 0;
+    for (; cursor < PackedBallot::kMaxChoices; ++cursor) {
+        choice = b.choice(cursor);
+        if (choice == 0 || in_race_[choice]) {
+            break;
+        }
+        choice = 0;
+    }
+    cursor_[ballot] = cursor;
+    piles_[choice].push_back(ballot);
+    counts_[choice] += b.count_;
+}
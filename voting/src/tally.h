@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2012-2025 tim cotter. All rights reserved.
+*/
+
+/**
+ranked ballots without rewriting them.
+
+every ballot has a cursor to its current choice.
+every candidate has a pile of the ballots currently choosing them.
+the pile for candidate 0 holds the exhausted ballots.
+
+eliminating a candidate only touches the ballots in their pile.
+each one moves its cursor to the next choice still in the race.
+or to a 0 choice which exhausts the ballot.
+so a whole ranked choice count is proportional to the ballots transferred.
+not the ballots times the rounds.
+
+the choices a rewritten ballot would have are still available.
+for methods that need more than the current choice.
+**/
+
+#pragma once
+
+#include "packed.h"
+
+#include <vector>
+
+
+class RankedTally {
+public:
+    RankedTally() = default;
+    RankedTally(const RankedTally &) = delete;
+    ~RankedTally() = default;
+
+    /** everybody is in the race. the ballots must outlive the tally. **/
+    void init(const PackedBallots& ballots, int ncandidates) noexcept;
+
+    /** weighted ballots currently choosing the candidate. **/
+    int count(int candidate) const noexcept { return counts_[candidate]; }
+
+    bool in_race(int candidate) const noexcept { return in_race_[candidate]; }
+
+    /** move the candidate's ballots to their next choice. **/
+    void eliminate(int candidate) noexcept;
+
+    /**
+    the ballot with the eliminated candidates removed.
+    same as removing them from the ballot and shifting the rest up.
+    **/
+    void get_choices(int ballot, int *choices) const noexcept;
+
+private:
+    const PackedBallots *ballots_ = nullptr;
+    std::vector<int> cursor_;
+    std::vector<std::vector<int>> piles_;
+    std::vector<int> counts_;
+    std::vector<char> in_race_;
+
+    /** the first choice at or after the cursor that's 0 or in the race. **/
+    void advance(int ballot) noexcept;
+};
@@ -9,12 +9,19 @@ spinning world example.
 #include "window.h"
 
 #include <aggiornamento/aggiornamento.h>
+#include <aggiornamento/cmd_line.h>
 #include <aggiornamento/log.h>
 #include <aggiornamento/master.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 
 namespace {
 	const auto kFrameTimeMS = 1000/60;
+	const auto kHeadlessFrames = 24*60;
 
     class World {
     public:
@@ -23,23 +30,115 @@ namespace {
         ~World() = default;
 
         WorldWindow *window_ = nullptr;
+        bool headless_ = false;
+        int max_frames_ = kHeadlessFrames;
+        const char *capture_ = nullptr;
+        bool stats_ = false;
+        bool overlay_ = false;
+
+        bool parseOptions(
+            int argc,
+            char *argv[]
+        ) noexcept {
+            agm::CmdLineOptions::LongFormat cmd_line_options[] = {
+                {"help",     '?'},
+                {"headless", 'H'},
+                {"frames",   'n'},
+                {"capture",  'c'},
+                {"stats",    'S'},
+                {"overlay",  'O'},
+                {nullptr, 0}
+            };
+            agm::CmdLineOptions clo(argc, argv, "?Hn:c:SO", cmd_line_options);
+            while (clo.get()) {
+                switch (clo.option_) {
+                case '?':
+                    showHelp();
+                    return false;
+
+                case 'H':
+                    headless_ = true;
+                    break;
+
+                case 'n':
+                    max_frames_ = std::atoi(clo.value_);
+                    break;
+
+                case 'S':
+                    stats_ = true;
+                    break;
+
+                case 'O':
+                    stats_ = true;
+                    overlay_ = true;
+                    break;
+
+                case 'c':
+                    capture_ = clo.value_;
+                    if (std::strcmp(capture_, "-") == 0) {
+                        // stdout is the video. keep the log out of it.
+                        agm::log::setConsole(&std::cerr);
+                    }
+                    break;
+                }
+            }
+            if (clo.error_) {
+                showHelp();
+                return false;
+            }
+            LOG("headless=" << headless_ << " frames=" << max_frames_
+                << " capture=" << (capture_ ? capture_ : "none")
+                << " stats=" << stats_ << " overlay=" << overlay_);
+            return true;
+        }
+
+        void showHelp() noexcept {
+            LOG("Usage: " AGM_TARGET_NAME " [options]");
+            LOG("  --help     -?  show this message");
+            LOG("  --headless -H  render offscreen as fast as possible");
+            LOG("  --frames   -n  number of frames to render headless");
+            LOG("  --capture  -c  capture frames to file.y4m or - for stdout");
+            LOG("                 anything else is a png file prefix");
+            LOG("  --stats    -S  log frame timing and draw stats");
+            LOG("  --overlay  -O  stats plus frame times on screen");
+        }
 
         void run() noexcept {
             window_ = WorldWindow::create();
-            window_->init();
+            window_->init(headless_, capture_, stats_, overlay_);
             runLoop();
             window_->exit();
             delete window_;
         }
 
+        /*
+        every frame is one fixed time step.
+        the window sleeps to run at about 60 fps.
+        headless runs as fast as it can.
+        */
         void runLoop() noexcept {
+            auto start = std::chrono::steady_clock::now();
+            int nframes = 0;
             for(;;) {
                 auto is_done = agm::master::isDone();
                 if (is_done) {
                     break;
                 }
-                //agm::sleep::milliseconds(kFrameTimeMS);
+                if (headless_) {
+                    if (nframes >= max_frames_) {
+                        break;
+                    }
+                } else {
+                    //agm::sleep::milliseconds(kFrameTimeMS);
+                }
                 window_->run();
+                ++nframes;
+            }
+            if (headless_) {
+                auto stop = std::chrono::steady_clock::now();
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+                LOG("frames=" << nframes << " ms=" << ms
+                    << " fps=" << (ms ? 1000.0 * nframes / ms : 0.0));
             }
         }
     };
@@ -48,13 +147,13 @@ namespace {
 int main(
     int argc, char *argv[]
 ) noexcept {
-    (void) argc;
-    (void) argv;
-
     agm::log::init(AGM_TARGET_NAME ".log");
 
     World world;
-    world.run();
+    auto good = world.parseOptions(argc, argv);
+    if (good) {
+        world.run();
+    }
 
     return 0;
 }